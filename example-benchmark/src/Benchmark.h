@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Minimal benchmark harness, in the spirit of Google Benchmark:
+ * each benchmark is a function running a given number of iterations,
+ * which is doubled until the run lasts long enough to be measured.
+ * Results are printed as a table, and can be written as CSV
+ * so that successive runs can be compared.
+ * */
+
+class Benchmark {
+
+  public:
+
+    struct Result {
+      std::string name;
+      std::uint64_t iterations;
+      double nsPerIteration;
+      double itemsPerSecond;
+    };
+
+    /*
+     * Passed to the benchmarks: the number of iterations to run,
+     * and the timer, which can be paused while preparing an iteration
+     * */
+    class State {
+      public:
+        explicit State(std::uint64_t iterations): iterations(iterations) {}
+
+        void pauseTiming(){ pausedAt = Clock::now(); }
+        void resumeTiming(){ excluded += Clock::now() - pausedAt; }
+
+        const std::uint64_t iterations;
+
+      private:
+        friend class Benchmark;
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point pausedAt;
+        Clock::duration excluded{};
+    };
+
+    using Function = std::function<void(State& state)>;
+
+    /**
+     * @brief registers a benchmark
+     * @param itemsPerIteration number of operations done by one iteration, for the throughput column
+     * @param maxIterations cap on the number of iterations, for the benchmarks that are slow to set up
+     */
+    static void add(const std::string& name, Function f,
+                    std::uint64_t itemsPerIteration = 1,
+                    std::uint64_t maxIterations = UINT64_MAX){
+      benchmarks().push_back({name, std::move(f), itemsPerIteration, maxIterations});
+    }
+
+    /**
+     * @brief runs all benchmarks whose name contains 'filter'
+     * @param minTime duration (in seconds) a run should last at least
+     */
+    static std::vector<Result> runAll(const std::string& filter = "", double minTime = 0.5){
+      std::vector<Result> results;
+      std::printf("%-48s %12s %14s %16s\n", "Benchmark", "Iterations", "ns/iteration", "items/s");
+      for (auto& b : benchmarks())
+      {
+        if (!filter.empty() && b.name.find(filter) == std::string::npos) continue;
+
+        std::uint64_t iterations = 1;
+        double elapsed = 0;
+        for (;;)
+        {
+          State state(iterations);
+          auto start = State::Clock::now();
+          b.function(state);
+          elapsed = std::chrono::duration<double>(State::Clock::now() - start - state.excluded).count();
+          if (elapsed >= minTime || iterations >= b.maxIterations) break;
+          // Aim directly at minTime when the last run is significant enough
+          std::uint64_t next = elapsed > minTime / 100
+            ? std::uint64_t(iterations * 1.2 * minTime / elapsed)
+            : iterations * 10;
+          iterations = std::min(std::max(next, iterations + 1), b.maxIterations);
+        }
+
+        Result r{b.name, iterations, elapsed * 1e9 / iterations,
+                 b.itemsPerIteration * iterations / elapsed};
+        std::printf("%-48s %12llu %14.1f %16.0f\n", r.name.c_str(),
+                    (unsigned long long) r.iterations, r.nsPerIteration, r.itemsPerSecond);
+        std::fflush(stdout);
+        results.push_back(r);
+      }
+      return results;
+    }
+
+    // Releases the benchmarks, along with what they hold
+    static void clear(){ benchmarks().clear(); }
+
+    static bool writeCSV(const std::string& path, const std::vector<Result>& results){
+      FILE* file = std::fopen(path.c_str(), "w");
+      if (!file) return false;
+      std::fprintf(file, "name,iterations,ns_per_iteration,items_per_second\n");
+      for (auto& r : results)
+        std::fprintf(file, "%s,%llu,%.3f,%.3f\n", r.name.c_str(),
+                     (unsigned long long) r.iterations, r.nsPerIteration, r.itemsPerSecond);
+      std::fclose(file);
+      return true;
+    }
+
+  private:
+
+    struct Entry {
+      std::string name;
+      Function function;
+      std::uint64_t itemsPerIteration;
+      std::uint64_t maxIterations;
+    };
+
+    static std::vector<Entry>& benchmarks(){
+      static std::vector<Entry> list;
+      return list;
+    }
+};
+
+// Prevents the compiler from optimizing away a computed value
+template<typename T>
+inline void doNotOptimize(const T& value){
+#if defined(_MSC_VER)
+  static volatile const void* sink;
+  sink = &value;
+#else
+  asm volatile("" : : "r"(&value) : "memory");
+#endif
+}
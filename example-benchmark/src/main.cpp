@@ -0,0 +1,641 @@
+#include "ofMain.h"
+#include "ofxOscQueryServer.h"
+#include "Benchmark.h"
+
+/*
+ * Headless benchmarks of ofxOscQuery's hot paths (no window, no GL):
+ * - building the tree of a server from an ofParameterGroup
+ * - looking nodes up, by path and by ofParameter
+ * - serving the namespace JSON, from its cache
+ * - publishing the changes of an ofParameter (listen), for each supported type
+ * - applying a value received by an ossia node to its ofParameter
+ * - converting values from and to opp::value, for each supported type
+ * - destroying nodes
+ * - taking, recalling, saving and loading snapshots
+ * - recording the values received and sent
+ * - creating and destroying instances
+ *
+ * usage: example-benchmark [--filter name] [--min-time seconds] [--csv file]
+ * */
+
+//--------------------------------------------------------------
+// Servers are created on a range of ports of their own,
+// so that successive servers don't have to wait for the ports to be released
+std::unique_ptr<ofxOscQueryServer> makeServer(ofParameterGroup& group){
+  static int port = 21000;
+  if (port > 29000) port = 21000;
+  int osc = port++, ws = port++;
+  std::unique_ptr<ofxOscQueryServer> server(new ofxOscQueryServer(osc, ws, "benchmark"));
+  server->setup(group, osc, ws);
+  return server;
+}
+
+// A group holding 'count' float parameters, by sub-groups of 100
+void makeTree(ofParameterGroup& group, std::size_t count){
+  group.setName("tree");
+  for (std::size_t g = 0; g * 100 < count; ++g)
+  {
+    ofParameterGroup sub;
+    sub.setName("g" + ofToString(g));
+    for (std::size_t p = g * 100; p < count && p < (g + 1) * 100; ++p)
+    {
+      ofParameter<float> param;
+      sub.add(param.set("p" + ofToString(p), 0, 0, 1));
+    }
+    group.add(sub);
+  }
+}
+
+// Finds the ossia node at 'path' (e.g. "/g0/p0"), as a remote client would address it
+opp::node findOssiaNode(opp::node node, const std::string& path){
+  for (const auto& name : ofSplitString(path, "/", true))
+  {
+    for (const auto& child : node.get_children())
+      if (child.get_name() == name) { node = child; break; }
+  }
+  return node;
+}
+
+//--------------------------------------------------------------
+// Two distinct values of each type, so that every set() is an actual change
+template<typename DataValue> DataValue sample(int i);
+template<> float        sample(int i){ return i ? 1.f : 0.f; }
+template<> int          sample(int i){ return i; }
+template<> bool         sample(int i){ return i != 0; }
+template<> double       sample(int i){ return i ? 1. : 0.; }
+template<> glm::vec2    sample(int i){ return glm::vec2(i, -i); }
+template<> glm::vec3    sample(int i){ return glm::vec3(i, -i, i); }
+template<> glm::vec4    sample(int i){ return glm::vec4(i, -i, i, -i); }
+template<> ofVec2f      sample(int i){ return ofVec2f(i, -i); }
+template<> ofVec3f      sample(int i){ return ofVec3f(i, -i, i); }
+template<> ofVec4f      sample(int i){ return ofVec4f(i, -i, i, -i); }
+template<> ofColor      sample(int i){ return ofColor(255 * i, 0, 255 * (1 - i)); }
+template<> ofFloatColor sample(int i){ return ofFloatColor(i, 0, 1 - i); }
+template<> std::string  sample(int i){ return i ? "a string value" : "another string value"; }
+template<> std::vector<float> sample(int i){ return std::vector<float>(512, i ? 1.f : 0.f); }
+
+//--------------------------------------------------------------
+void addTreeBenchmarks(std::size_t count){
+  std::string size = "/" + ofToString(count);
+  // Only a few runs of the largest trees
+  std::uint64_t maxIterations = std::max<std::uint64_t>(3, 100000 / count);
+
+  Benchmark::add("buildTreeFrom" + size, [count](Benchmark::State& state){
+    ofParameterGroup tree;
+    makeTree(tree, count);
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      state.pauseTiming();
+      ofParameterGroup root;
+      root.setName("benchmark");
+      auto server = makeServer(root);
+      state.resumeTiming();
+
+      server->buildTreeFrom(tree, server->getRootNode());
+
+      state.pauseTiming();
+      server.reset();
+      state.resumeTiming();
+    }
+  }, count, maxIterations);
+
+  // Sub-groups lazy (see setLazy()): only their group nodes are created
+  Benchmark::add("buildTreeFrom(lazy)" + size, [count](Benchmark::State& state){
+    ofParameterGroup tree;
+    makeTree(tree, count);
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      state.pauseTiming();
+      ofParameterGroup root;
+      root.setName("benchmark");
+      auto server = makeServer(root);
+      for (auto& sub : tree) server->setLazy(static_cast<ofParameterGroup&>(*sub));
+      state.resumeTiming();
+
+      server->buildTreeFrom(tree, server->getRootNode());
+
+      state.pauseTiming();
+      server.reset();
+      state.resumeTiming();
+    }
+  }, count, maxIterations);
+
+  Benchmark::add("removeGroup" + size, [count](Benchmark::State& state){
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      state.pauseTiming();
+      ofParameterGroup root, tree;
+      root.setName("benchmark");
+      makeTree(tree, count);
+      root.add(tree);
+      auto server = makeServer(root);
+      state.resumeTiming();
+
+      server->removeGroup(tree);
+
+      state.pauseTiming();
+      server.reset();
+      state.resumeTiming();
+    }
+  }, count, maxIterations);
+}
+
+//--------------------------------------------------------------
+void addLookupBenchmarks(std::size_t count){
+  std::string size = "/" + ofToString(count);
+
+  // Shared by both lookups, built on first use
+  struct Fixture {
+    ofParameterGroup root, tree;
+    std::unique_ptr<ofxOscQueryServer> server;
+    std::vector<std::string> paths;
+    std::vector<ofAbstractParameter*> params;
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture, count]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    makeTree(fixture->tree, count);
+    fixture->root.add(fixture->tree);
+    fixture->server = makeServer(fixture->root);
+    for (auto& group : fixture->tree)
+      for (auto& param : group->castGroup())
+      {
+        fixture->paths.push_back("/tree/" + group->getName() + "/" + param->getName());
+        fixture->params.push_back(param.get());
+      }
+  };
+
+  Benchmark::add("operator[](path)" + size, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    auto& server = *fixture->server;
+    std::size_t n = fixture->paths.size();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(server[fixture->paths[i % n]]);
+  });
+
+  Benchmark::add("operator[](ofParameter)" + size, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    auto& server = *fixture->server;
+    std::size_t n = fixture->params.size();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(server[*fixture->params[i % n]]);
+  });
+}
+
+//--------------------------------------------------------------
+void addSelectBenchmarks(std::size_t count){
+  std::string size = "/" + ofToString(count);
+
+  struct Fixture {
+    ofParameterGroup root, tree;
+    std::unique_ptr<ofxOscQueryServer> server;
+    std::vector<std::string> paths;
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture, count]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    makeTree(fixture->tree, count);
+    fixture->root.add(fixture->tree);
+    fixture->server = makeServer(fixture->root);
+    for (auto& group : fixture->tree)
+      for (auto& param : group->castGroup())
+        fixture->paths.push_back("/tree/" + group->getName() + "/" + param->getName());
+  };
+  // the 1000 parameters of 10 groups
+  const std::string pattern = "/tree/g{1,2,3,4,5,6,7,8,9,10}/*";
+
+  Benchmark::add("select(pattern)" + size, [fixture, prepare, pattern](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(fixture->server->select(pattern).size());
+  });
+
+  // For reference: the same pattern, matched against every path
+  Benchmark::add("match every path" + size, [fixture, prepare, pattern](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    ofxOssiaPathPattern compiled(pattern);
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      std::size_t matched = 0;
+      for (const std::string& path : fixture->paths) matched += compiled.matches(path);
+      doNotOptimize(matched);
+    }
+  });
+
+  Benchmark::add("select(pattern).set" + size, [fixture, prepare, pattern](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    ofxOssiaSelection selection = fixture->server->select(pattern);
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(selection.set(i & 1 ? 1.f : 0.f));
+  }, 1000);
+}
+
+//--------------------------------------------------------------
+void addAttributeBenchmarks(std::size_t count){
+  std::string size = "/" + ofToString(count);
+
+  struct Fixture {
+    ofParameterGroup root, tree;
+    std::unique_ptr<ofxOscQueryServer> server;
+    std::vector<ofAbstractParameter*> params;
+    ofxOssiaAttributes table;
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture, count]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    makeTree(fixture->tree, count);
+    fixture->root.add(fixture->tree);
+    fixture->server = makeServer(fixture->root);
+    fixture->table["/tree/**"].setClipMode("both").setUnit("gain.linear");
+    for (auto& group : fixture->tree)
+      for (auto& param : group->castGroup())
+      {
+        fixture->params.push_back(param.get());
+        fixture->table[*param].setDescription("parameter " + param->getName()).setRangeMax(2.f);
+      }
+  };
+
+  // The same attributes for every parameter: one by one, then as a table
+  Benchmark::add("attribute setters" + size, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    auto& server = *fixture->server;
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      for (ofAbstractParameter* param : fixture->params)
+        server[*param].setClipMode("both").setUnit("gain.linear")
+                      .setDescription("parameter " + param->getName()).setRangeMax(2.f);
+  }, count);
+
+  Benchmark::add("apply(attributes)" + size, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(fixture->server->apply(fixture->table));
+  }, count);
+}
+
+//--------------------------------------------------------------
+void addSnapshotBenchmarks(std::size_t count){
+  std::string size = "/" + ofToString(count);
+
+  struct Fixture {
+    ofParameterGroup root, tree;
+    std::unique_ptr<ofxOscQueryServer> server;
+    ofxOssiaSnapshot snapshot;
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture, count]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    makeTree(fixture->tree, count);
+    fixture->root.add(fixture->tree);
+    fixture->server = makeServer(fixture->root);
+    fixture->snapshot = fixture->server->snapshot();
+  };
+
+  Benchmark::add("snapshot" + size, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(fixture->server->snapshot());
+  }, count);
+
+  // Nothing changed: only the comparisons
+  Benchmark::add("recall(unchanged)" + size, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(fixture->server->recall(fixture->snapshot));
+  }, count);
+
+  Benchmark::add("save+loadSnapshot" + size, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    std::string file = ofToDataPath("benchmark.snapshot", true);
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      ofxOssiaSnapshot loaded;
+      fixture->server->saveSnapshot(fixture->snapshot, file);
+      fixture->server->loadSnapshot(loaded, file);
+      doNotOptimize(loaded);
+    }
+  }, count);
+}
+
+//--------------------------------------------------------------
+template<typename DataValue>
+void addTypeBenchmarks(const std::string& typeName){
+  // One server per type, built on first use
+  struct Fixture {
+    ofParameterGroup root;
+    ofParameter<DataValue> param;
+    std::unique_ptr<ofxOscQueryServer> server;
+    opp::node node;
+    opp::value values[2];
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    fixture->root.add(fixture->param.set("param", sample<DataValue>(0)));
+    fixture->server = makeServer(fixture->root);
+    fixture->node = findOssiaNode(fixture->server->getDevice().get_root_node(), "/param");
+    for (int i = 0; i < 2; ++i)
+      fixture->values[i] = ossia::MatchingType<DataValue>::convert(sample<DataValue>(i));
+  };
+
+  // ofParameter::set -> listener -> ossia node
+  Benchmark::add("listen/" + typeName, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    const DataValue values[2] = {sample<DataValue>(0), sample<DataValue>(1)};
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      fixture->param.set(values[(i + 1) & 1]);
+  });
+
+  // The conversions alone, done for every value received or sent
+  Benchmark::add("convertFromOssia/" + typeName, [](Benchmark::State& state){
+    state.pauseTiming();
+    using ossia_type = ossia::MatchingType<DataValue>;
+    const opp::value values[2] = {opp::value(ossia_type::convert(sample<DataValue>(0))),
+                                  opp::value(ossia_type::convert(sample<DataValue>(1)))};
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      const opp::value& value = values[i & 1];
+      if (ossia_type::is_valid(value)) doNotOptimize(ossia_type::convertFromOssia(value));
+    }
+  });
+
+  Benchmark::add("convert/" + typeName, [](Benchmark::State& state){
+    state.pauseTiming();
+    const DataValue values[2] = {sample<DataValue>(0), sample<DataValue>(1)};
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      doNotOptimize(opp::value(ossia::MatchingType<DataValue>::convert(values[i & 1])));
+  });
+
+  // ossia node -> value callback -> ofParameter::set
+  Benchmark::add("inbound/" + typeName, [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      fixture->node.set_value(fixture->values[(i + 1) & 1]);
+  });
+}
+
+// The same paths, when values received are deferred and/or output is coalesced
+void addUpdateBenchmarks(){
+  struct Fixture {
+    ofParameterGroup root;
+    ofParameter<float> param;
+    std::unique_ptr<ofxOscQueryServer> server;
+    opp::node node;
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    fixture->root.add(fixture->param.set("param", 0, 0, 1));
+    fixture->server = makeServer(fixture->root);
+    fixture->server->setDeferredUpdates(true);
+    fixture->server->setCoalescedOutput(true);
+    fixture->node = findOssiaNode(fixture->server->getDevice().get_root_node(), "/param");
+  };
+
+  Benchmark::add("listen+flush/float", [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      fixture->param.set(float((i + 1) & 1));
+      fixture->server->flush();
+    }
+  });
+
+  Benchmark::add("inbound+applyPendingUpdates/float", [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    const opp::value values[2] = {opp::value(0.f), opp::value(1.f)};
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      fixture->node.set_value(values[(i + 1) & 1]);
+      fixture->server->applyPendingUpdates();
+    }
+  });
+}
+
+// A renderer whose position, size and color are changed together by a client,
+// the application listening to the changes of its group
+void addTransactionBenchmarks(){
+  struct Fixture {
+    ofParameterGroup root, renderer;
+    ofParameter<glm::vec2> position;
+    ofParameter<float> size;
+    ofParameter<ofFloatColor> color;
+    std::unique_ptr<ofxOscQueryServer> server;
+    opp::node nodes[3];
+    std::uint64_t changes = 0;
+    void changed(ofAbstractParameter&){ ++changes; }
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    fixture->renderer.setName("renderer");
+    fixture->renderer.add(fixture->position.set("position", glm::vec2(0, 0)));
+    fixture->renderer.add(fixture->size.set("size", 0, 0, 1));
+    fixture->renderer.add(fixture->color.set("color", ofFloatColor(0)));
+    fixture->root.add(fixture->renderer);
+    ofAddListener(fixture->renderer.parameterChangedE(), fixture.get(), &Fixture::changed);
+    fixture->server = makeServer(fixture->root);
+    fixture->server->setDeferredUpdates(true);
+    opp::node root = fixture->server->getDevice().get_root_node();
+    fixture->nodes[0] = findOssiaNode(root, "/renderer/position");
+    fixture->nodes[1] = findOssiaNode(root, "/renderer/size");
+    fixture->nodes[2] = findOssiaNode(root, "/renderer/color");
+  };
+  auto receive = [](Fixture& fixture, std::uint64_t i){
+    float v = float((i + 1) & 1);
+    fixture.nodes[0].set_value(opp::value(opp::value::vec2f{v, v}));
+    fixture.nodes[1].set_value(opp::value(v));
+    fixture.nodes[2].set_value(opp::value(opp::value::vec4f{v, v, v, 1}));
+  };
+
+  Benchmark::add("inbound+applyPendingUpdates/3 params", [fixture, prepare, receive](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    fixture->server->setTransactional(fixture->renderer, false);
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      receive(*fixture, i);
+      fixture->server->applyPendingUpdates();
+    }
+  }, 3);
+
+  Benchmark::add("inbound+commitTransaction/3 params", [fixture, prepare, receive](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    fixture->server->setTransactional(fixture->renderer);
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      receive(*fixture, i);
+      fixture->server->commitTransaction(fixture->renderer);
+    }
+  }, 3);
+}
+
+// The same paths, while recording (to a log large enough for all iterations)
+void addRecordingBenchmarks(){
+  struct Fixture {
+    ofParameterGroup root;
+    ofParameter<float> param;
+    std::unique_ptr<ofxOscQueryServer> server;
+    opp::node node;
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture](std::uint64_t iterations){
+    if (!fixture->server)
+    {
+      fixture->root.setName("benchmark");
+      fixture->root.add(fixture->param.set("param", 0, 0, 1));
+      fixture->server = makeServer(fixture->root);
+      fixture->node = findOssiaNode(fixture->server->getDevice().get_root_node(), "/param");
+    }
+    fixture->server->startRecording(ofToDataPath("benchmark.log", true), iterations * 64 + 4096);
+  };
+
+  Benchmark::add("listen+record/float", [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare(state.iterations);
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      fixture->param.set(float((i + 1) & 1));
+    state.pauseTiming();
+    fixture->server->stopRecording();
+    state.resumeTiming();
+  });
+
+  Benchmark::add("inbound+record/float", [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare(state.iterations);
+    const opp::value values[2] = {opp::value(0.f), opp::value(1.f)};
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+      fixture->node.set_value(values[(i + 1) & 1]);
+    state.pauseTiming();
+    fixture->server->stopRecording();
+    state.resumeTiming();
+  });
+}
+
+//--------------------------------------------------------------
+void addInstanceBenchmarks(){
+  // Instances of a voice of 8 parameters, created and destroyed in turn (see addInstances())
+  struct Fixture {
+    ofParameterGroup root, voices, prototype;
+    ofParameter<float> params[8];
+    std::unique_ptr<ofxOscQueryServer> server;
+    ofxOssiaInstances* instances = nullptr;
+  };
+  auto fixture = std::make_shared<Fixture>();
+  auto prepare = [fixture]{
+    if (fixture->server) return;
+    fixture->root.setName("benchmark");
+    fixture->voices.setName("voices");
+    fixture->root.add(fixture->voices);
+    fixture->prototype.setName("voice");
+    for (int i = 0; i < 8; ++i) fixture->prototype.add(fixture->params[i].set("p" + ofToString(i), 0, 0, 1));
+    fixture->server = makeServer(fixture->root);
+    fixture->instances = fixture->server->addInstances(fixture->prototype, fixture->voices, 0, 64);
+    // fills the pool
+    for (int i = 0; i < 64; ++i) fixture->instances->create();
+    for (int i = 64; i > 0; --i) fixture->instances->destroy(i);
+  };
+
+  Benchmark::add("instances/create+destroy", [fixture, prepare](Benchmark::State& state){
+    state.pauseTiming();
+    prepare();
+    state.resumeTiming();
+    for (std::uint64_t i = 0; i < state.iterations; ++i)
+    {
+      fixture->instances->create();
+      fixture->instances->destroy(1);
+    }
+  });
+}
+
+//========================================================================
+int main(int argc, char** argv){
+
+  std::string filter, csv;
+  double minTime = 0.5;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    std::string arg = argv[i];
+    if (arg == "--filter")        filter = argv[i + 1];
+    else if (arg == "--min-time") minTime = ofToDouble(argv[i + 1]);
+    else if (arg == "--csv")      csv = argv[i + 1];
+  }
+
+  ofSetLogLevel(OF_LOG_WARNING);
+
+  for (std::size_t count : {1000, 10000, 100000}) addTreeBenchmarks(count);
+  addLookupBenchmarks(10000);
+  addSelectBenchmarks(50000);
+  addAttributeBenchmarks(10000);
+  addSnapshotBenchmarks(10000);
+
+  addTypeBenchmarks<float>("float");
+  addTypeBenchmarks<int>("int");
+  addTypeBenchmarks<bool>("bool");
+  addTypeBenchmarks<double>("double");
+  addTypeBenchmarks<glm::vec2>("glm::vec2");
+  addTypeBenchmarks<glm::vec3>("glm::vec3");
+  addTypeBenchmarks<glm::vec4>("glm::vec4");
+  addTypeBenchmarks<ofVec2f>("ofVec2f");
+  addTypeBenchmarks<ofVec3f>("ofVec3f");
+  addTypeBenchmarks<ofVec4f>("ofVec4f");
+  addTypeBenchmarks<ofColor>("ofColor");
+  addTypeBenchmarks<ofFloatColor>("ofFloatColor");
+  addTypeBenchmarks<std::string>("std::string");
+  addTypeBenchmarks<std::vector<float>>("std::vector<float>[512]");
+  addUpdateBenchmarks();
+  addTransactionBenchmarks();
+  addRecordingBenchmarks();
+  addInstanceBenchmarks();
+
+  auto results = Benchmark::runAll(filter, minTime);
+  // Destroys the servers still held by the benchmarks
+  Benchmark::clear();
+  if (!csv.empty() && !Benchmark::writeCSV(csv, results))
+  {
+    std::cerr << "Could not write " << csv << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * Send and receive timestamps of a sequence of messages,
+ * identified by their sequence number.
+ * Messages are sent from one thread and received from any other,
+ * only the first reception of each message being taken into account.
+ * */
+
+class LatencyProbe {
+
+  public:
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Report {
+      std::size_t sent = 0;
+      std::size_t received = 0;
+      // latencies, in nanoseconds
+      double p50 = 0, p99 = 0, p999 = 0, max = 0;
+      // from the first message sent to the last one received
+      double messagesPerSecond = 0;
+    };
+
+    explicit LatencyProbe(std::size_t count):
+      count(count), sent(new std::atomic<std::int64_t>[count]), received(new std::atomic<std::int64_t>[count]){
+      for (std::size_t i = 0; i < count; ++i) { sent[i].store(0); received[i].store(0); }
+    }
+
+    void send(std::size_t sequence){
+      sent[sequence].store(now(), std::memory_order_release);
+    }
+
+    void receive(int sequence){
+      if (sequence < 0 || std::size_t(sequence) >= count) return;
+      std::int64_t unset = 0;
+      if (received[sequence].compare_exchange_strong(unset, now())) ++arrived;
+    }
+
+    bool complete() const { return arrived.load() == count; }
+
+    Report report() const {
+      Report r;
+      std::vector<std::int64_t> latencies;
+      latencies.reserve(count);
+      std::int64_t first = INT64_MAX, last = 0;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        std::int64_t s = sent[i].load(), e = received[i].load();
+        if (s) { ++r.sent; first = std::min(first, s); }
+        if (s && e) { latencies.push_back(e - s); last = std::max(last, e); }
+      }
+      r.received = latencies.size();
+      if (latencies.empty()) return r;
+
+      std::sort(latencies.begin(), latencies.end());
+      auto percentile = [&](double p){ return double(latencies[std::size_t(p * (latencies.size() - 1))]); };
+      r.p50  = percentile(0.5);
+      r.p99  = percentile(0.99);
+      r.p999 = percentile(0.999);
+      r.max  = double(latencies.back());
+      if (last > first) r.messagesPerSecond = r.received * 1e9 / (last - first);
+      return r;
+    }
+
+  private:
+
+    static std::int64_t now(){
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    const std::size_t count;
+    std::unique_ptr<std::atomic<std::int64_t>[]> sent, received;
+    std::atomic<std::size_t> arrived{0};
+};
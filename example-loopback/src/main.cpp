@@ -0,0 +1,298 @@
+#include "ofMain.h"
+#include "ofxOsc.h"
+#include "ofxOscQueryServer.h"
+#include "LatencyProbe.h"
+#include <thread>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Headless loopback harness (no window, no GL), measuring end to end:
+ * - in:  a message sent by a client -> the ofParameter's listener
+ * - out: ofParameter::set -> the value received by a client
+ * for a server on free local ports, and in-process clients:
+ * - osc: messages sent with ofxOsc, and values received through UDP
+ * - ws:  an OSCQuery mirror, the parameters being marked as critical
+ *        so that their values go through the WebSocket
+ *
+ * Every message carries a sequence number (as an int value), sent to the
+ * parameters in turn, which identifies its send and receive timestamps.
+ *
+ * usage: example-loopback [--params 100] [--rate 10000] [--duration 5]
+ *                         [--transport osc|ws] [--direction in|out|both]
+ *                         [--csv file]
+ * */
+
+struct Options {
+  std::size_t params = 100;
+  double rate = 10000;     // messages per second
+  double duration = 5;     // seconds
+  std::string transport = "osc";
+  std::string direction = "both";
+  std::string csv;
+};
+
+//--------------------------------------------------------------
+// Asks the system for a free local port, by binding a socket to port 0
+int freePort(int type){
+#if defined(_WIN32)
+  static WSADATA wsa;
+  static int started = WSAStartup(MAKEWORD(2, 2), &wsa);
+  (void) started;
+  SOCKET s = socket(AF_INET, type, 0);
+  int length;
+#else
+  int s = socket(AF_INET, type, 0);
+  socklen_t length;
+#endif
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  int port = 0;
+  if (bind(s, (sockaddr*) &address, sizeof(address)) == 0)
+  {
+    length = sizeof(address);
+    if (getsockname(s, (sockaddr*) &address, &length) == 0) port = ntohs(address.sin_port);
+  }
+#if defined(_WIN32)
+  closesocket(s);
+#else
+  close(s);
+#endif
+  return port;
+}
+
+// Sends 'count' messages at 'rate' messages per second, send(k) sending the k-th one
+template<typename Send>
+void drive(std::size_t count, double rate, LatencyProbe& probe, Send send){
+  using Clock = LatencyProbe::Clock;
+  auto start = Clock::now();
+  for (std::size_t k = 0; k < count; ++k)
+  {
+    auto due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(k / rate));
+    for (auto now = Clock::now(); now < due; now = Clock::now())
+    {
+      if (due - now > std::chrono::milliseconds(2)) std::this_thread::sleep_for(due - now - std::chrono::milliseconds(1));
+      else std::this_thread::yield();
+    }
+    probe.send(k);
+    send(k);
+  }
+}
+
+// Waits for the messages still on their way
+void drain(LatencyProbe& probe, double timeout = 2){
+  auto end = LatencyProbe::Clock::now() + std::chrono::duration_cast<LatencyProbe::Clock::duration>(std::chrono::duration<double>(timeout));
+  while (!probe.complete() && LatencyProbe::Clock::now() < end)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+//--------------------------------------------------------------
+class Loopback {
+
+  public:
+
+    Loopback(const Options& options): options(options) {}
+
+    bool setup(){
+      oscPort = freePort(SOCK_DGRAM);
+      wsPort  = freePort(SOCK_STREAM);
+      if (!oscPort || !wsPort) { ofLogError("loopback") << "no free port"; return false; }
+
+      parameters.setName("loopback");
+      params.resize(options.params);
+      for (std::size_t i = 0; i < params.size(); ++i)
+        parameters.add(params[i].set("p" + ofToString(i), -1));
+
+      server.reset(new ofxOscQueryServer(oscPort, wsPort, "loopback"));
+      server->setup(parameters, oscPort, wsPort);
+      if (options.transport == "ws")
+        for (auto& p : params) (*server)[p].setCritical(true);
+
+      sender.setup("127.0.0.1", oscPort);
+
+      // The mirror gets the namespace from the server, then keeps polling it
+      mirror.reset(new opp::oscquery_mirror("loopback-client", "ws://127.0.0.1:" + ofToString(wsPort)));
+      mirror->refresh();
+      mirrorNodes.resize(params.size());
+      auto timeout = LatencyProbe::Clock::now() + std::chrono::seconds(5);
+      while (!findMirrorNodes())
+      {
+        if (LatencyProbe::Clock::now() > timeout) { ofLogError("loopback") << "the mirror could not get the namespace"; return false; }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        mirror->update();
+      }
+      polling = true;
+      poller = std::thread([this]{
+        while (polling) { mirror->update(); std::this_thread::sleep_for(std::chrono::microseconds(100)); }
+      });
+      return true;
+    }
+
+    ~Loopback(){
+      polling = false;
+      if (poller.joinable()) poller.join();
+      for (auto& node : mirrorNodes)
+        if (node.callback) node.node.remove_value_callback(node.index);
+      for (auto& p : params) p.removeListener(this, &Loopback::onParameter);
+    }
+
+    // Remote message -> ofParameter listener
+    LatencyProbe::Report runInbound(){
+      std::size_t count = std::size_t(options.rate * options.duration);
+      LatencyProbe probe(count);
+      current = &probe;
+      for (auto& p : params) p.addListener(this, &Loopback::onParameter);
+
+      std::size_t n = params.size();
+      if (options.transport == "ws")
+        drive(count, options.rate, probe, [&](std::size_t k){
+          mirrorNodes[k % n].node.set_value(opp::value(int(k)));
+        });
+      else
+      {
+        ofxOscMessage message;
+        drive(count, options.rate, probe, [&](std::size_t k){
+          message.clear();
+          message.setAddress("/p" + ofToString(k % n));
+          message.addIntArg(int(k));
+          sender.sendMessage(message, false);
+        });
+      }
+      drain(probe);
+
+      for (auto& p : params) p.removeListener(this, &Loopback::onParameter);
+      current = nullptr;
+      return probe.report();
+    }
+
+    // ofParameter::set -> message received by the client
+    LatencyProbe::Report runOutbound(){
+      std::size_t count = std::size_t(options.rate * options.duration);
+      LatencyProbe probe(count);
+      current = &probe;
+      for (auto& node : mirrorNodes)
+      {
+        node.index = node.node.set_value_callback(&Loopback::onMirrorValue, this);
+        node.callback = true;
+      }
+
+      std::size_t n = params.size();
+      drive(count, options.rate, probe, [&](std::size_t k){
+        params[k % n].set(int(k));
+      });
+      drain(probe);
+
+      for (auto& node : mirrorNodes)
+      {
+        node.node.remove_value_callback(node.index);
+        node.callback = false;
+      }
+      current = nullptr;
+      return probe.report();
+    }
+
+  private:
+
+    bool findMirrorNodes(){
+      std::size_t found = 0;
+      for (const auto& child : mirror->get_root_node().get_children())
+      {
+        std::string name = child.get_name();
+        if (name.size() < 2 || name[0] != 'p') continue;
+        std::size_t i = ofToInt(name.substr(1));
+        if (i < mirrorNodes.size()) { mirrorNodes[i].node = child; ++found; }
+      }
+      return found == mirrorNodes.size();
+    }
+
+    void onParameter(int& sequence){
+      if (auto probe = current.load()) probe->receive(sequence);
+    }
+
+    static void onMirrorValue(void* context, const opp::value& value){
+      auto self = static_cast<Loopback*>(context);
+      auto probe = self->current.load();
+      if (probe && value.is_int()) probe->receive(value.to_int());
+    }
+
+    struct MirrorNode {
+      opp::node node;
+      opp::callback_index index;
+      bool callback = false;
+    };
+
+    const Options& options;
+    int oscPort = 0, wsPort = 0;
+    ofParameterGroup parameters;
+    std::vector<ofParameter<int>> params;
+    std::unique_ptr<ofxOscQueryServer> server;
+    ofxOscSender sender;
+    std::unique_ptr<opp::oscquery_mirror> mirror;
+    std::vector<MirrorNode> mirrorNodes;
+    std::thread poller;
+    std::atomic<bool> polling{false};
+    std::atomic<LatencyProbe*> current{nullptr};
+};
+
+//--------------------------------------------------------------
+void writeReport(const Options& options, const std::string& direction, const LatencyProbe::Report& r){
+  const char* header = "direction,transport,params,rate,sent,received,lost,p50_us,p99_us,p999_us,max_us,messages_per_second\n";
+  char line[512];
+  std::snprintf(line, sizeof(line), "%s,%s,%zu,%.0f,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.0f\n",
+                direction.c_str(), options.transport.c_str(), options.params, options.rate,
+                r.sent, r.received, r.sent - r.received,
+                r.p50 / 1e3, r.p99 / 1e3, r.p999 / 1e3, r.max / 1e3, r.messagesPerSecond);
+
+  static bool first = true;
+  if (first) std::fputs(header, stdout);
+  std::fputs(line, stdout);
+  std::fflush(stdout);
+
+  if (!options.csv.empty())
+  {
+    // Appended to, so that runs can be gathered in one file
+    FILE* file = std::fopen(options.csv.c_str(), "r");
+    bool exists = file;
+    if (file) std::fclose(file);
+    file = std::fopen(options.csv.c_str(), "a");
+    if (!file) { std::cerr << "Could not write " << options.csv << std::endl; return; }
+    if (!exists) std::fputs(header, file);
+    std::fputs(line, file);
+    std::fclose(file);
+  }
+  first = false;
+}
+
+//========================================================================
+int main(int argc, char** argv){
+
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    std::string arg = argv[i];
+    if (arg == "--params")         options.params = std::max(1, ofToInt(argv[i + 1]));
+    else if (arg == "--rate")      options.rate = std::max(1., ofToDouble(argv[i + 1]));
+    else if (arg == "--duration")  options.duration = ofToDouble(argv[i + 1]);
+    else if (arg == "--transport") options.transport = argv[i + 1];
+    else if (arg == "--direction") options.direction = argv[i + 1];
+    else if (arg == "--csv")       options.csv = argv[i + 1];
+  }
+
+  ofSetLogLevel(OF_LOG_WARNING);
+
+  Loopback loopback(options);
+  if (!loopback.setup()) return 1;
+
+  if (options.direction != "out") writeReport(options, "in", loopback.runInbound());
+  if (options.direction != "in")  writeReport(options, "out", loopback.runOutbound());
+  return 0;
+}
@@ -32,6 +32,10 @@ class ofApp : public ofBaseApp{
         // Notice that we need to declare ports to our servers //
         // or they would get the same default ports            //
         // and would conflict with each other.                 //
+        // Alternatively, they can share the same ports (and   //
+        // network threads), each one under its own node:      //
+        // ofxOscQueryServer server1{ofxOscQueryEngine::shared()};
+        // ofxOscQueryServer server2{ofxOscQueryEngine::shared()};
         // We will attach them to ofParameterGroups in ofApp.cpp
         //*****************************************************//
 };
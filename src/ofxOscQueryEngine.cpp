@@ -0,0 +1,54 @@
+#include "ofxOscQueryEngine.h"
+#include <iostream>
+#include <map>
+#include <utility>
+
+std::shared_ptr<ofxOscQueryEngine> ofxOscQueryEngine::shared(int localPortOSC, int localPortWS, std::string name)
+{
+  // not owning the engines: they're released with the last server using them
+  static std::mutex registryMutex;
+  static std::map<std::pair<int, int>, std::weak_ptr<ofxOscQueryEngine>> registry;
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::weak_ptr<ofxOscQueryEngine>& entry = registry[std::make_pair(localPortOSC, localPortWS)];
+  std::shared_ptr<ofxOscQueryEngine> engine = entry.lock();
+  if (!engine){
+    engine = std::make_shared<ofxOscQueryEngine>(name, localPortOSC, localPortWS);
+    engine->setup(name, localPortOSC, localPortWS);
+    entry = engine;
+  }
+  else if (name != DEFAULT_NAME && name != engine->name)
+    std::cout << "ofxOscQueryEngine: ports " << localPortOSC << "/" << localPortWS
+              << " already shared as " << engine->name << std::endl;
+  return engine;
+}
+
+void ofxOscQueryEngine::setup(std::string localName, int localPortOSC, int localPortWS)
+{
+  name = localName;
+  OSCport = localPortOSC;
+  WSport = localPortWS;
+  device.setup(name, OSCport, WSport);
+  // This will echo the controls from clients to the output
+  device.set_echo(true);
+}
+
+opp::node ofxOscQueryEngine::mount(const std::string& prefix)
+{
+  std::lock_guard<std::mutex> lock(mountMutex);
+  ++mounts;
+  return device.get_root_node().create_child(prefix);
+}
+
+void ofxOscQueryEngine::unmount(const opp::node& node)
+{
+  std::lock_guard<std::mutex> lock(mountMutex);
+  --mounts;
+  device.get_root_node().remove_child(node.get_name());
+}
+
+std::size_t ofxOscQueryEngine::getMountCount()
+{
+  std::lock_guard<std::mutex> lock(mountMutex);
+  return mounts;
+}
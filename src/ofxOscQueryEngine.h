@@ -0,0 +1,70 @@
+#pragma once
+#undef Status
+#undef Bool
+#undef bool
+#undef False
+#undef status
+#undef None
+#include <ossia-cpp98.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define DEFAULT_OSC 1234
+#define DEFAULT_WS  5678
+#define DEFAULT_NAME "ofxOscQuery"
+
+/*
+ * The network side of OSCQuery servers: an ossia device, with its OSC and WebSocket
+ * ports and threads.
+ * By default, each ofxOscQueryServer owns its own engine; a shared engine
+ * (see shared()) instead exposes several servers through the same ports and threads,
+ * each one being mounted under its own prefix of the namespace ("/renderer1", "/renderer2"...),
+ * so that the number of threads and ports stays constant with the number of servers
+ * */
+
+class ofxOscQueryEngine {
+
+  public:
+
+    ofxOscQueryEngine(std::string name = DEFAULT_NAME, int localPortOSC = DEFAULT_OSC, int localPortWS = DEFAULT_WS):
+      name(name), OSCport(localPortOSC), WSport(localPortWS),
+      device(name, localPortOSC, localPortWS){
+    }
+    ofxOscQueryEngine(const ofxOscQueryEngine&) = delete;
+    ofxOscQueryEngine& operator=(const ofxOscQueryEngine&) = delete;
+
+    /**
+     * @brief the engine of the process listening on these ports, created
+     * (and its device set up) by the first call, and released with the last server using it
+     */
+    static std::shared_ptr<ofxOscQueryEngine> shared(int localPortOSC = DEFAULT_OSC,
+                                                     int localPortWS = DEFAULT_WS,
+                                                     std::string name = DEFAULT_NAME);
+
+    // (Re)creates the device, on other ports or with another name
+    void setup(std::string name, int localPortOSC, int localPortWS);
+
+    /**
+     * @brief creates the node under which a server is exposed, at the root of the device
+     * @return its node, named after 'prefix' (or "prefix.1"... when that name is already taken)
+     */
+    opp::node mount(const std::string& prefix);
+    // Removes the node of a server, once its nodes have been removed
+    void unmount(const opp::node& node);
+    std::size_t getMountCount();
+
+    opp::oscquery_server& getDevice(){ return device; }
+    const std::string& getName(){ return name; }
+    int getOSCPort(){ return OSCport; }
+    int getWSPort(){ return WSport; }
+
+  private:
+
+    std::string name;
+    int OSCport, WSport;
+    opp::oscquery_server device;
+    // the servers mount and unmount from their own thread
+    std::mutex mountMutex;
+    std::size_t mounts = 0;
+};
@@ -7,6 +7,84 @@
 //
 
 #include "ofxOscQueryServer.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Paths are compared without their leading and trailing '/',
+// so that "/renderer/color/", "/renderer/color" and "renderer/color" all match
+void trimPath(const char*& path, std::size_t& length)
+{
+  if (length > 0 && path[0] == '/')        { ++path; --length; }
+  if (length > 0 && path[length-1] == '/') { --length; }
+}
+
+// The object shared by all the references to a parameter, which isReferenceTo() compares
+// (reached through a derived class, as ofAbstractParameter keeps it protected)
+struct ParameterObject : ofAbstractParameter {
+  static const void* get(const ofAbstractParameter& param){
+    return (param.*&ParameterObject::getInternalObject)();
+  }
+};
+
+// The metrics published under /_stats, in the order of their nodes
+struct Stat {
+  const char* name;
+  bool isCount;
+  double (*get)(const ofxOssiaServerMetrics& metrics);
+};
+
+const Stat stats[] = {
+  {"received",        true,  [](const ofxOssiaServerMetrics& m){ return double(m.totals.received.load()); }},
+  {"sent",            true,  [](const ofxOssiaServerMetrics& m){ return double(m.totals.sent.load()); }},
+  {"mismatches",      true,  [](const ofxOssiaServerMetrics& m){ return double(m.totals.mismatches.load()); }},
+  {"applied",         true,  [](const ofxOssiaServerMetrics& m){ return double(m.applied.load()); }},
+  {"flushed",         true,  [](const ofxOssiaServerMetrics& m){ return double(m.flushed.load()); }},
+  {"callback_p50_us", false, [](const ofxOssiaServerMetrics& m){ return m.callbackTime.percentile(0.5) / 1000; }},
+  {"callback_p99_us", false, [](const ofxOssiaServerMetrics& m){ return m.callbackTime.percentile(0.99) / 1000; }},
+  {"publish_p50_us",  false, [](const ofxOssiaServerMetrics& m){ return m.publishTime.percentile(0.5) / 1000; }},
+  {"publish_p99_us",  false, [](const ofxOssiaServerMetrics& m){ return m.publishTime.percentile(0.99) / 1000; }},
+};
+
+// Snapshot files: magic, version, number of columns, then for each column:
+// name of its type, number of values, their paths, size (in bytes) and values
+// (version 1 named the types as typeid().name() does, depending on the compiler)
+const char snapshotMagic[4] = {'O', 'S', 'Q', 'S'};
+const std::uint32_t snapshotVersion = 2;
+
+template<typename T>
+void writeRaw(std::ostream& out, T v){ out.write(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+template<typename T>
+bool readRaw(std::istream& in, T& v){ return bool(in.read(reinterpret_cast<char*>(&v), sizeof(v))); }
+
+// Whether a parameter is within a group, or one of its sub-groups
+bool contains(ofParameterGroup& group, ofAbstractParameter& param)
+{
+  for (std::size_t i = 0; i < group.size(); ++i){
+    ofAbstractParameter& child = group.get(i);
+    if (child.isReferenceTo(param)) return true;
+    if (typeid(child) == typeid(ofParameterGroup) && contains(group.getGroup(i), param)) return true;
+  }
+  return false;
+}
+
+// FNV-1a, computed in place so that lookups don't need to build a normalized copy
+std::size_t hashPath(const char* path, std::size_t length)
+{
+  std::size_t hash = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < length; ++i){
+    hash ^= static_cast<unsigned char>(path[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}
 
 void ofxOscQueryServer::setup(ofParameterGroup& group, int localportOSC, int localPortWS, std::string localname)
 {
@@ -16,90 +94,1267 @@ void ofxOscQueryServer::setup(ofParameterGroup& group, int localportOSC, int loc
                                {serverName = group.getName();}
     else if (localname != "" ) {serverName = localname;}
     
-    std::cout << "servername: " << serverName << std::endl;
-    
-    // set ports and name of the OSCQuery device
-    device.setup(serverName, OSCport, WSport);
-    nodes.emplace_back(device, group);
-    
-    // This will echo the controls from clients to the output
-    device.set_echo(true);
+    if (sharedEngine){
+      if (OSCport != engine->getOSCPort() || WSport != engine->getWSPort())
+        ofLogWarning("ofxOscQueryServer") << serverName << " uses the ports of its shared engine";
+      OSCport = engine->getOSCPort();
+      WSport = engine->getWSPort();
+
+      // mounted under its name, at the root of the shared device
+      mount.node = engine->mount(serverName);
+      mount.engine = engine;
+      serverName = mount.node.get_name();
+      std::cout << "servername: " << serverName << " (shared by " << engine->getName() << ")" << std::endl;
+      createNode(mount.node, group, tree);
+    }
+    else {
+      std::cout << "servername: " << serverName << std::endl;
+
+      // set ports and name of the OSCQuery device (which echoes the controls from clients to the output)
+      engine->setup(serverName, OSCport, WSport);
+      createNode(engine->getDevice().get_root_node(), group, tree);
+    }
     
     // Then build ossia tree up from the chosen parameterGroup
-    buildTreeFrom(group, nodes.front());
+    buildTreeFrom(group, getRootNode());
     
 }
 
 void ofxOscQueryServer::buildTreeFrom(ofParameterGroup& group, ofxOssiaNode& node)
 {
-
   // Traverse all children recursively and create Nodes for each of them
   for(std::size_t i = 0; i < group.size(); i++){
-    std::string type = group.get(i).type();
+    // unsupported parameters are skipped, the rest of the group still being exposed
+    if(!createChild(node, group, i)){
+      ofLogWarning() << "ofxBaseGroup; no support for parameter of type " << group.get(i).type(); continue;
+    }
+  }
+
+}
+
+ofxOssiaNode* ofxOscQueryServer::createChild(ofxOssiaNode& node, ofParameterGroup& group, std::size_t i)
+{
+  std::type_index type = typeid(group.get(i));
+  ofxOssiaNode* child = nullptr;
+
+  if(type == typeid(ofParameterGroup)){
+
+    // Create a Node for this Group
+    child = &createNode(node, group.getGroup(i));
+
+    // Create sub-tree for Group (once materialized, for lazy groups)
+    if(isMarkedLazy(group.getGroup(i))) makeLazy(*child);
+    else buildTreeFrom(group.getGroup(i), *child);
+
+  } else {  // This is a Parameter
+
+    // Find parameter type, and create Node accordingly:
+    auto& registry = typeRegistry();
+    auto entry = registry.find(type);
+    if(entry == registry.end()) return nullptr;
+    child = &entry->second.create(*this, node, group.get(i));
+
+  }
+
+  // Keep the group's reference to the parameter alive as long as its node,
+  // even if it gets removed from the group before the node
+  child->paramRef = *(group.begin() + i);
+  return child;
+}
+
+ofxOssiaNode* ofxOscQueryServer::addParameter(ofAbstractParameter& param, ofParameterGroup& parent)
+{
+  ofxOssiaNode* parentNode = find(parent);
+  if (!parentNode || typeid(*parentNode->ofParam) != typeid(ofParameterGroup)){
+    ofLogWarning() << "ofxOscQueryServer::addParameter: group " << parent.getName() << " is not exposed by this server";
+    return nullptr;
+  }
+  ofParameterGroup& group = static_cast<ofParameterGroup&>(*parentNode->ofParam);
+
+  // Add the parameter to its group, if needed
+  std::size_t i = 0;
+  while (i < group.size() && !group.get(i).isReferenceTo(param)) ++i;
+  if (i == group.size()) group.add(param);
+
+  // A collapsed lazy group exposes all its parameters at once
+  auto lazy = lazyGroups.find(parentNode->handle);
+  if (lazy != lazyGroups.end() && !lazy->second->materialized) materialize(*lazy->second);
+
+  // ... and expose it, if not already done
+  for (std::uint32_t h = parentNode->firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling)
+    if (nodes[h].ofParam == &group.get(i)) return &nodes[h];
+
+  ofxOssiaNode* child = createChild(*parentNode, group, i);
+  if (!child) ofLogWarning() << "ofxOscQueryServer::addParameter: no support for parameter of type " << param.type();
+  return child;
+}
+
+ofxOssiaNode* ofxOscQueryServer::addGroup(ofParameterGroup& group, ofParameterGroup& parent)
+{
+  return addParameter(group, parent);
+}
+
+bool ofxOscQueryServer::removeParameter(ofAbstractParameter& param)
+{
+  ofxOssiaNode* node = find(param);
+  if (!node || node->handle == getRootNode().handle) return false;
+
+  ofParameterGroup& group = static_cast<ofParameterGroup&>(*nodes[node->parent].ofParam);
+  removeNode(*node);
+
+  // Remove the parameter from its group too, if still there
+  for (std::size_t i = 0; i < group.size(); ++i){
+    if (group.get(i).isReferenceTo(param)){ group.remove(i); break; }
+  }
+  return true;
+}
+
+bool ofxOscQueryServer::removeGroup(ofParameterGroup& group)
+{
+  return removeParameter(group);
+}
+
+void ofxOscQueryServer::sync()
+{
+  unexposedParams.clear();
+  if (!nodes.empty()) syncNode(getRootNode());
+}
+
+void ofxOscQueryServer::sync(ofParameterGroup& group)
+{
+  unexposedParams.clear();
+  ofxOssiaNode* node = find(group);
+  if (node && typeid(*node->ofParam) == typeid(ofParameterGroup)) syncNode(*node);
+}
+
+void ofxOscQueryServer::syncNode(ofxOssiaNode& node)
+{
+  // collapsed lazy groups are synced when materialized
+  auto lazy = lazyGroups.find(node.handle);
+  if (lazy != lazyGroups.end() && !lazy->second->materialized) return;
+
+  ofParameterGroup& group = static_cast<ofParameterGroup&>(*node.ofParam);
+
+  // The nodes of the group's children, by address of the group's references to them
+  std::unordered_map<const ofAbstractParameter*, std::uint32_t> existing;
+  for (std::uint32_t h = node.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling)
+    if (!nodes[h].pooled.load()) existing.emplace(nodes[h].ofParam, h);
+
+  for (std::size_t i = 0; i < group.size(); ++i){
+    auto found = existing.find(&group.get(i));
+    if (found != existing.end()){
+      // Still there, look for changes in its own children
+      ofxOssiaNode& child = nodes[found->second];
+      existing.erase(found);
+      if (typeid(*child.ofParam) == typeid(ofParameterGroup)) syncNode(child);
+    }
+    else if (!createChild(node, group, i)){
+      ofLogWarning() << "ofxOscQueryServer::sync: no support for parameter of type " << group.get(i).type();
+    }
+  }
+
+  // No longer in the group
+  for (auto& removed : existing) removeNode(nodes[removed.second]);
+}
+
+void ofxOscQueryServer::removeNode(ofxOssiaNode& node)
+{
+  // Instances within the group go with it, and an instance removed on its own is forgotten
+  for (auto& instances : instancers)
+    if (instances->parentHandle == node.handle) instances->detach();
+  if (!instanceNodes.empty()){
+    auto instance = instanceNodes.find(node.handle);
+    if (instance != instanceNodes.end()){
+      instance->second->forget(node.handle);
+      instanceNodes.erase(instance);
+    }
+    pooledNodes.erase(node.handle);
+  }
+
+  // Children first, while their parent's ossia node still exists
+  while (node.firstChild != ofxOssiaNode::none) removeNode(nodes[node.firstChild]);
+
+  ofxOssiaNode* parent = nodes.get(node.parent);
+  std::string name = node.currentNode.get_name();
+  if (!lazyGroups.empty()) removeLazyGroup(node);
+  if (!transactions.empty()) removeTransaction(node);
+  unlinkNode(node);
+  unindexNode(node);
+  tree.paths.release(node.path);
+  nodes.erase(node.handle);
+  if (parent) parent->currentNode.remove_child(name);
+}
+
+
+ofxOssiaInstances* ofxOscQueryServer::addInstances(ofParameterGroup& prototype, ofParameterGroup& parent, int min, int max)
+{
+  ofxOssiaNode* parentNode = find(parent);
+  if (!parentNode || typeid(*parentNode->ofParam) != typeid(ofParameterGroup)){
+    ofLogWarning() << "ofxOscQueryServer::addInstances: group " << parent.getName() << " is not exposed by this server";
+    return nullptr;
+  }
+  ofParameterGroup& group = static_cast<ofParameterGroup&>(*parentNode->ofParam);
+  instancers.emplace_back(new ofxOssiaInstances(*this, prototype, group, parentNode->handle, parentNode->currentNode, min, max));
+  return instancers.back().get();
+}
 
-    if(type==typeid(ofParameterGroup).name()){
+void ofxOscQueryServer::removeInstances(ofxOssiaInstances& instances)
+{
+  for (auto& instance : instances.instances){
+    if (!instance.group) continue;
+    if (instance.alive) instances.parent.remove(*instance.group);
+    ofxOssiaNode* node = nodes.get(instance.handle);
+    if (node) removeNode(*node);
+  }
+  instances.detach();
+  instancers.erase(std::remove_if(instancers.begin(), instancers.end(),
+    [&](const std::unique_ptr<ofxOssiaInstances>& i){ return i.get() == &instances; }), instancers.end());
+}
+
+std::shared_ptr<ofParameterGroup> ofxOscQueryServer::cloneGroup(ofParameterGroup& prototype)
+{
+  std::shared_ptr<ofParameterGroup> clone = std::make_shared<ofParameterGroup>();
+  clone->setName(prototype.getName());
+  auto& registry = typeRegistry();
+  for (std::size_t i = 0; i < prototype.size(); ++i){
+    ofAbstractParameter& param = prototype.get(i);
+    if (typeid(param) == typeid(ofParameterGroup)){
+      clone->add(*cloneGroup(prototype.getGroup(i)));
+      continue;
+    }
+    // unsupported parameters wouldn't be exposed anyway
+    auto entry = registry.find(typeid(param));
+    if (entry != registry.end()) clone->add(*entry->second.clone(param));
+  }
+  return clone;
+}
+
+void ofxOscQueryServer::resetGroup(ofParameterGroup& group, ofParameterGroup& prototype)
+{
+  // both made of the same (supported) parameters, in the same order
+  auto& registry = typeRegistry();
+  std::size_t i = 0;
+  for (std::size_t j = 0; j < prototype.size() && i < group.size(); ++j){
+    ofAbstractParameter& from = prototype.get(j);
+    if (typeid(from) == typeid(ofParameterGroup)){
+      resetGroup(group.getGroup(i++), prototype.getGroup(j));
+      continue;
+    }
+    auto entry = registry.find(typeid(from));
+    if (entry != registry.end()) entry->second.assign(group.get(i++), from);
+  }
+}
+
+void ofxOscQueryServer::poolNode(ofxOssiaNode& node)
+{
+  node.setHidden(true);
+  // disabled for clients, and ignoring what's still received
+  // (the lists are kept from one pooling to the next, so that churn doesn't allocate)
+  auto& disabled = pooledNodes[node.handle];
+  disabled.clear();
+  std::vector<std::uint32_t>& pending = pooledScratch;
+  pending.assign(1, node.handle);
+  while (!pending.empty()){
+    ofxOssiaNode& n = nodes[pending.back()];
+    pending.pop_back();
+    n.pooled.store(true, std::memory_order_release);
+    if (!n.currentNode.get_disabled()){
+      n.currentNode.set_disabled(true);
+      disabled.emplace_back(n.handle, n.generation);
+    }
+    if (n.slot) n.slot->discard();
+    for (std::uint32_t h = n.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling) pending.push_back(h);
+  }
+  tree.namespaceChanged = true;
+}
+
+void ofxOscQueryServer::unpoolNode(ofxOssiaNode& node, std::shared_ptr<ofAbstractParameter> paramRef)
+{
+  // back in its parent group, as a new reference (see syncNode()) to the same parameter:
+  // its path and the object it's indexed by are unchanged
+  node.paramRef = std::move(paramRef);
+  node.ofParam = node.paramRef.get();
+
+  auto pooled = pooledNodes.find(node.handle);
+  if (pooled != pooledNodes.end()){
+    // unless collapsed with a lazy group meanwhile
+    for (auto& h : pooled->second)
+      if (ofxOssiaNode* n = nodes.get(h.first, h.second)) n->currentNode.set_disabled(false);
+  }
+  std::vector<std::uint32_t>& pending = pooledScratch;
+  pending.assign(1, node.handle);
+  while (!pending.empty()){
+    ofxOssiaNode& n = nodes[pending.back()];
+    pending.pop_back();
+    // a value received just before it was pooled mustn't override the prototype's
+    if (n.slot) n.slot->discard();
+    n.pooled.store(false, std::memory_order_release);
+    for (std::uint32_t h = n.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling) pending.push_back(h);
+  }
+  node.setHidden(false);
+}
+
+ofxOscQueryServer::~ofxOscQueryServer()
+{
+  // before the containers they unregister from (instanceNodes...) are destroyed
+  for (auto& instances : instancers) instances->detach();
+  instancers.clear();
+}
 
-      // Create a Node for this Group at the end of the list
-      nodes.emplace_back(node, group.getGroup(i));
+std::unordered_map<std::type_index, ofxOscQueryServer::TypeEntry>& ofxOscQueryServer::typeRegistry()
+{
+  static std::unordered_map<std::type_index, TypeEntry> registry;
+  static bool initialized = false;
+  if (!initialized){
+    initialized = true;
+    registerTypes(ossia::MatchingTypes{});
+  }
+  return registry;
+}
 
-      // Create sub-tree for Group
-      buildTreeFrom(group.getGroup(i), nodes.back());
+void ofxOscQueryServer::setDeferredUpdates(bool deferred, std::size_t capacity)
+{
+  tree.inbound.setDeferred(deferred, std::max(capacity, nodes.size()));
+}
 
-    } else {  // This is a Parameter
+void ofxOscQueryServer::setCoalescedOutput(bool coalesce, float rate)
+{
+  flushRate = rate;
+  if (!coalesce) flush();
+  tree.outbound.setCoalescing(coalesce);
+}
 
-      // Check parameter type, and create Node accordingly:
-      if(type == typeid(ofParameter <int32_t>).name())
-        nodes.emplace_back(node, group.get<int32_t>(i));
-      else if(type == typeid(ofParameter <int>).name())
-        nodes.emplace_back(node, group.get<int>(i));
-      else if(type == typeid(ofParameter <float>).name())
-        nodes.emplace_back(node, group.get<float>(i));
-      else if(type == typeid(ofParameter <double>).name())
-        nodes.emplace_back(node, group.get<double>(i));
-      else if(type == typeid(ofParameter <bool>).name())
-        nodes.emplace_back(node, group.get<bool>(i));
-      else if(type == typeid(ofParameter <ofVec2f>).name())
-        nodes.emplace_back(node, group.get<ofVec2f>(i));
-      else if(type == typeid(ofParameter <ofVec3f>).name())
-        nodes.emplace_back(node, group.get<ofVec3f>(i));
-      else if(type == typeid(ofParameter <ofVec4f>).name())
-        nodes.emplace_back(node, group.get<ofVec4f>(i));
-      else if(type == typeid(ofParameter <ofColor>).name())
-        nodes.emplace_back(node, group.get<ofColor>(i));
-      else if(type == typeid(ofParameter <ofFloatColor>).name())
-        nodes.emplace_back(node, group.get<ofFloatColor>(i));
-      else if(type == typeid(ofParameter <std::string>).name())
-        nodes.emplace_back(node, group.get<std::string>(i));
-      else{ ofLogWarning() << "ofxBaseGroup; no support for parameter of type " << type; break; }
+void ofxOscQueryServer::update()
+{
+  handleLazyRequests();
+  enforceLazyCapacity();
+  for (auto& instances : instancers) instances->handleRequests();
+  applyPendingUpdates();
+  handleCommitRequests();
+  reclaimStagedUpdates();
+  notifyNamespace();
+
+  auto now = std::chrono::steady_clock::now();
+  if (!statsNodes.empty() && now - lastStats >= std::chrono::seconds(1)){
+    lastStats = now;
+    publishMetrics();
+  }
+
+  if (tree.outbound.empty()) return;
+  if (flushRate > 0 && now - lastFlush < std::chrono::duration<float>(1.f / flushRate)) return;
+  lastFlush = now;
+  flush();
+}
+
+std::size_t ofxOscQueryServer::flush()
+{
+  dueNodes.clear();
+  waitingNodes.clear();
+  tree.outbound.consume([&](std::uint32_t handle){
+    ofxOssiaNode* node = nodes.get(handle);
+    if (!node || !node->ops) return;
+    if (node->isDue() && node->isSettled()) dueNodes.push_back(handle);
+    else waitingNodes.push_back(handle);
+  });
+
+  if (outputBudget > 0 && dueNodes.size() > outputBudget){
+    std::stable_sort(dueNodes.begin(), dueNodes.end(), [&](std::uint32_t a, std::uint32_t b){
+      return nodes[a].priority > nodes[b].priority;
+    });
+    waitingNodes.insert(waitingNodes.end(), dueNodes.begin() + outputBudget, dueNodes.end());
+    dueNodes.resize(outputBudget);
+  }
+
+  std::size_t published = 0;
+  for (std::uint32_t handle : dueNodes){
+    ofxOssiaNode& node = nodes[handle];
+    (node.*node.ops->publish)();
+    ++published;
+  }
+  // not published yet, but their latest value will be
+  for (std::uint32_t handle : waitingNodes) tree.outbound.mark(handle);
+  if (tree.metrics.isEnabled()) tree.metrics.flushed += published;
+  return published;
+}
 
+std::size_t ofxOscQueryServer::applyPendingUpdates()
+{
+  std::size_t applied = tree.inbound.applyPending();
+  if (tree.metrics.isEnabled()) tree.metrics.applied += applied;
+  return applied;
+}
+
+void ofxOscQueryServer::setMetrics(bool enabled, bool exposed, unsigned sampling)
+{
+  tree.metrics.setEnabled(enabled, sampling);
+
+  exposed = enabled && exposed;
+  if (exposed && nodes.empty()){
+    ofLogWarning() << "ofxOscQueryServer::setMetrics: metrics can only be exposed once the server is set up";
+    exposed = false;
+  }
+  if (exposed == !statsNodes.empty()) return;
+
+  opp::node root = getRootNode().getNode();
+  tree.namespaceChanged = true;
+  if (!exposed){
+    statsNodes.clear();
+    root.remove_child(statsRoot.get_name());
+    return;
+  }
+
+  statsRoot = root.create_child("_stats");
+  for (const Stat& stat : stats){
+    opp::node node = stat.isCount ? statsRoot.create_int(stat.name) : statsRoot.create_float(stat.name);
+    node.set_access(opp::access_mode::Get);
+    statsNodes.push_back(node);
+  }
+  publishMetrics();
+}
+
+std::size_t ofxOscQueryServer::apply(const ofxOssiaAttributes& attributes)
+{
+  std::size_t changed = nodes.empty() ? 0 : applyEntries(attributes.entries, getRootNode());
+  notifyNamespace();
+  return changed;
+}
+
+std::size_t ofxOscQueryServer::applyEntries(const std::vector<ofxOssiaAttributes::Entry>& entries, ofxOssiaNode& from)
+{
+  // Entries of a parameter or of a literal path are looked up once,
+  // the others are matched against the path of every node
+  std::unordered_multimap<std::uint32_t, std::size_t> targeted;
+  std::vector<std::size_t> patterns;
+  // and those, along with the entries whose node isn't exposed, may apply within collapsed lazy groups
+  std::vector<std::size_t> deferrable;
+  for (std::size_t i = 0; i < entries.size(); ++i){
+    const ofxOssiaAttributes::Entry& entry = entries[i];
+    if (entry.empty()) continue;
+    ofxOssiaNode* node = nullptr;
+    if (entry.param) node = findParam(*entry.param);
+    else if (entry.pattern.isLiteral()) node = findPath(entry.pattern.str().data(), entry.pattern.str().size());
+    else { patterns.push_back(i); deferrable.push_back(i); continue; }
+    if (node) targeted.emplace(node->handle, i);
+    else deferrable.push_back(i);
+  }
+
+  std::size_t changed = 0;
+  std::vector<std::size_t> matched;
+  std::vector<std::uint32_t> pending{from.handle};
+  std::string fullPath;
+  while (!pending.empty()){
+    ofxOssiaNode& node = nodes[pending.back()];
+    pending.pop_back();
+    tree.paths.get(node.path, fullPath);
+    const char* path = fullPath.data();
+    std::size_t length = fullPath.size();
+    if (length > 1 && path[length - 1] == '/') --length;
+
+    matched.clear();
+    auto range = targeted.equal_range(node.handle);
+    for (auto it = range.first; it != range.second; ++it) matched.push_back(it->second);
+    for (std::size_t i : patterns)
+      if (entries[i].pattern.matches(path, length)) matched.push_back(i);
+    if (!matched.empty()){
+      // in the order of the table, the last entries overriding the first ones
+      std::sort(matched.begin(), matched.end());
+      for (std::size_t i : matched) applyEntry(node, entries[i]);
+      ++changed;
     }
 
+    auto lazy = lazyGroups.find(node.handle);
+    if (lazy != lazyGroups.end() && !lazy->second->materialized){
+      ofParameterGroup& group = static_cast<ofParameterGroup&>(*node.ofParam);
+      for (std::size_t i : deferrable){
+        const ofxOssiaAttributes::Entry& entry = entries[i];
+        if (entry.param ? contains(group, *entry.param) : entry.pattern.mayMatchBelow(path, length))
+          lazy->second->attributes.entries.push_back(entry);
+      }
+      continue;
+    }
+    for (std::uint32_t h = node.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling)
+      pending.push_back(h);
   }
+  return changed;
+}
 
+void ofxOscQueryServer::applyEntry(ofxOssiaNode& node, const ofxOssiaAttributes::Entry& entry)
+{
+  using Entry = ofxOssiaAttributes::Entry;
+  if (entry.has(Entry::Description)) node.setDescription(entry.description);
+  if (entry.has(Entry::Tags))        node.setTags(entry.tags);
+  if (entry.has(Entry::Hidden))      node.setHidden(entry.hidden);
+  // the others only apply to parameters
+  if (!node.ops) return;
+  if (entry.has(Entry::Access))           node.setAccess(entry.access);
+  if (entry.has(Entry::ClipMode))         node.setClipMode(entry.clipMode);
+  if (entry.has(Entry::Unit))             node.setUnit(entry.unit);
+  if (entry.has(Entry::Critical))         node.setCritical(entry.critical);
+  if (entry.has(Entry::Disabled))         node.setDisabled(entry.disabled);
+  if (entry.has(Entry::Muted))            node.setMuted(entry.muted);
+  if (entry.has(Entry::RepetitionFilter)) node.setRepetitionFilter(entry.repetitionFilter);
+  if (entry.has(Entry::Priority))         node.setPriority(entry.priority);
+  if (entry.has(Entry::RefreshRate))      node.setRefreshRate(entry.refreshRate);
+  if (entry.has(Entry::ValueStepSize))    node.setValueStepSize(entry.valueStepSize);
+  if (entry.has(Entry::RangeMin) || entry.has(Entry::RangeMax))
+    (node.*node.ops->setRange)(entry.has(Entry::RangeMin) ? &entry.rangeMin : nullptr,
+                               entry.has(Entry::RangeMax) ? &entry.rangeMax : nullptr);
 }
 
+void ofxOscQueryServer::notifyNamespace()
+{
+  if (!tree.namespaceChanged) return;
+  tree.namespaceChanged = false;
+  ++namespaceVersion;
+  if (namespaceListener) namespaceListener(namespaceVersion);
+}
+
+void ofxOscQueryServer::publishMetrics()
+{
+  for (std::size_t i = 0; i < statsNodes.size(); ++i){
+    double value = stats[i].get(tree.metrics);
+    if (stats[i].isCount) statsNodes[i].set_value(opp::value(int(std::min<double>(value, INT_MAX))));
+    else                  statsNodes[i].set_value(opp::value(float(value)));
+  }
+}
+
+void ofxOscQueryServer::linkNode(ofxOssiaNode& node)
+{
+  ofxOssiaNode* parent = nodes.get(node.parent);
+  if (!parent) return;
+  tree.namespaceChanged = true;
+  // the values received within a transactional group are staged
+  node.staged = parent->staged.load();
+  if (parent->lastChild == ofxOssiaNode::none) parent->firstChild = node.handle;
+  else nodes[parent->lastChild].nextSibling = node.handle;
+  parent->lastChild = node.handle;
+}
+
+void ofxOscQueryServer::unlinkNode(ofxOssiaNode& node)
+{
+  tree.namespaceChanged = true;
+  ofxOssiaNode* parent = nodes.get(node.parent);
+  if (!parent) return;
+  std::uint32_t previous = ofxOssiaNode::none;
+  std::uint32_t h = parent->firstChild;
+  while (h != ofxOssiaNode::none && h != node.handle){ previous = h; h = nodes[h].nextSibling; }
+  if (h == ofxOssiaNode::none) return;
+
+  if (previous == ofxOssiaNode::none) parent->firstChild = node.nextSibling;
+  else nodes[previous].nextSibling = node.nextSibling;
+  if (parent->lastChild == node.handle) parent->lastChild = previous;
+  node.nextSibling = ofxOssiaNode::none;
+}
+
+void ofxOscQueryServer::indexNode(ofxOssiaNode& node)
+{
+  tree.paths.get(node.path, pathScratch);
+  const char* path = pathScratch.data();
+  std::size_t length = pathScratch.size();
+  trimPath(path, length);
+  pathIndex.emplace(hashPath(path, length), node.handle);
+  paramIndex.emplace(ParameterObject::get(*node.ofParam), node.handle);
+}
 
-ofxOssiaNode& ofxOscQueryServer::operator[](std::string targetPath)
+void ofxOscQueryServer::unindexNode(ofxOssiaNode& node)
 {
-  std::string tPath = targetPath;
-  if (targetPath.back()!='/') tPath=tPath+'/';
-  if (targetPath.front()!='/') tPath='/'+tPath;
-  auto found = find_if(nodes.begin(), nodes.end(),
-                       [&](ofxOssiaNode& n){return n.getPath()==tPath;});
-  if (found!=nodes.end()) return *found;
+  tree.paths.get(node.path, pathScratch);
+  const char* path = pathScratch.data();
+  std::size_t length = pathScratch.size();
+  trimPath(path, length);
+  auto candidates = pathIndex.equal_range(hashPath(path, length));
+  for (auto it = candidates.first; it != candidates.second; ++it){
+    if (it->second == node.handle){ pathIndex.erase(it); break; }
+  }
+  // the same parameter may be exposed twice
+  auto references = paramIndex.equal_range(ParameterObject::get(*node.ofParam));
+  for (auto it = references.first; it != references.second; ++it){
+    if (it->second == node.handle){ paramIndex.erase(it); break; }
+  }
+}
+
+void ofxOscQueryServer::compactPaths()
+{
+  ofxOssiaPathPool compacted;
+  ofxOssiaNode& root = getRootNode();
+  root.path = compacted.root();
+  // parents first, their children's paths being built from theirs
+  std::vector<std::uint32_t> pending{root.handle};
+  while (!pending.empty()){
+    ofxOssiaNode& node = nodes[pending.back()];
+    pending.pop_back();
+    for (std::uint32_t h = node.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling){
+      ofxOssiaNode& child = nodes[h];
+      child.path = compacted.add(node.path, tree.paths.name(child.path), tree.paths.nameLength(child.path));
+      pending.push_back(h);
+    }
+  }
+  tree.paths = std::move(compacted);
+}
+
+ofxOssiaNode* ofxOscQueryServer::findPath(const char* targetPath, std::size_t length)
+{
+  trimPath(targetPath, length);
+  auto candidates = pathIndex.equal_range(hashPath(targetPath, length));
+  for (auto it = candidates.first; it != candidates.second; ++it){
+    ofxOssiaNode& node = nodes[it->second];
+    if (tree.paths.equals(node.path, targetPath, length)) return &node;
+  }
+  return nullptr;
+}
+
+ofxOssiaNode* ofxOscQueryServer::lookupPath(const char* targetPath, std::size_t length)
+{
+  ofxOssiaNode* node = findPath(targetPath, length);
+  while (!node && materializeFor(targetPath, length)) node = findPath(targetPath, length);
+  if (node && node->lazyGroup.load(std::memory_order_relaxed)) node->touch();
+  return node;
+}
+
+ofxOssiaNode* ofxOscQueryServer::find(const std::string& targetPath)
+{
+  return lookupPath(targetPath.c_str(), targetPath.size());
+}
+
+ofxOssiaNode* ofxOscQueryServer::find(const char* targetPath)
+{
+  return lookupPath(targetPath, std::strlen(targetPath));
+}
+
+ofxOssiaNode* ofxOscQueryServer::find(ofAbstractParameter& targetParam)
+{
+  ofxOssiaNode* node = findParam(targetParam);
+  if (!node && !isUnexposed(targetParam)){
+    while (!node && materializeFor(targetParam)) node = findParam(targetParam);
+    // not within a lazy group either: the next lookups of this parameter don't search them again
+    if (!node && !lazyGroups.empty())
+      unexposedParams.emplace(ParameterObject::get(targetParam), targetParam.newReference());
+  }
+  if (node && node->lazyGroup.load(std::memory_order_relaxed)) node->touch();
+  return node;
+}
+
+ofxOssiaNode* ofxOscQueryServer::findParam(ofAbstractParameter& targetParam)
+{
+  // any reference to the parameter (the group's, or the application's own) leads to its node
+  auto indexed = paramIndex.find(ParameterObject::get(targetParam));
+  return indexed != paramIndex.end() ? &nodes[indexed->second] : nullptr;
+}
+
+bool ofxOscQueryServer::isUnexposed(ofAbstractParameter& targetParam)
+{
+  return !unexposedParams.empty() && unexposedParams.count(ParameterObject::get(targetParam));
+}
+
+ofxOssiaNode& ofxOscQueryServer::operator[](const std::string& targetPath)
+{
+  ofxOssiaNode* found = find(targetPath);
+  if (found) return *found;
+  return getRootNode();
+}
+
+ofxOssiaNode& ofxOscQueryServer::operator[](const char* targetPath)
+{
+  ofxOssiaNode* found = find(targetPath);
+  if (found) return *found;
   return getRootNode();
 }
 
 ofxOssiaNode& ofxOscQueryServer::operator[](ofAbstractParameter& targetParam)
 {
-  auto found = find_if(nodes.begin(), nodes.end(),
-                       [&](ofxOssiaNode& n) {return (n.getParam()->isReferenceTo(targetParam));});
-  if (found!=nodes.end()) return *found;
+  ofxOssiaNode* found = find(targetParam);
+  if (found) return *found;
   return getRootNode();
 }
 
+ofxOssiaSelection ofxOscQueryServer::select(const std::string& pattern)
+{
+  std::vector<std::uint32_t> selected;
+  const ofxOssiaPathPattern& compiled = compilePattern(pattern);
+  // the literal start of the pattern is looked up, the rest is matched level by level
+  std::string directory = compiled.getDirectory();
+  ofxOssiaNode* start = nodes.empty() ? nullptr : lookupPath(directory.data(), directory.size());
+  if (start){
+    if (compiled.isLiteral()) selected.push_back(start->handle);
+    else selectNodes(*start, compiled, 0, selected);
+  }
+  std::vector<std::uint32_t> generations;
+  generations.reserve(selected.size());
+  for (std::uint32_t h : selected) generations.push_back(nodes.generation(h));
+  return ofxOssiaSelection(*this, std::move(selected), std::move(generations));
+}
 
+const ofxOssiaPathPattern& ofxOscQueryServer::compilePattern(const std::string& pattern)
+{
+  auto compiled = compiledPatterns.find(pattern);
+  if (compiled != compiledPatterns.end()) return compiled->second;
+  // scripts may build many distinct patterns: only keep the latest ones
+  if (compiledPatterns.size() >= 256) compiledPatterns.clear();
+  return compiledPatterns.emplace(pattern, ofxOssiaPathPattern(pattern)).first->second;
+}
 
+void ofxOscQueryServer::selectNodes(ofxOssiaNode& node, const ofxOssiaPathPattern& pattern, std::size_t i,
+                                    std::vector<std::uint32_t>& selected)
+{
+  const std::vector<ofxOssiaPathPattern::Segment>& segments = pattern.getSegments();
+  if (i == segments.size()){
+    selected.push_back(node.handle);
+    return;
+  }
+
+  // the nodes of a collapsed lazy group are created to be matched
+  auto lazy = lazyGroups.find(node.handle);
+  if (lazy != lazyGroups.end() && !lazy->second->materialized) materialize(*lazy->second);
 
+  const ofxOssiaPathPattern::Segment& segment = segments[i];
+  if (segment.kind == ofxOssiaPathPattern::Segment::Rest){
+    // any number of levels: the whole sub-tree is matched against the pattern
+    tree.paths.get(node.path, pathScratch);
+    std::size_t length = pathScratch.size();
+    if (length > 1) --length;
+    if (pattern.matches(pathScratch.data(), length)) selected.push_back(node.handle);
+    for (std::uint32_t h = node.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling)
+      selectNodes(nodes[h], pattern, i, selected);
+    return;
+  }
 
+  for (std::uint32_t h = node.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling){
+    ofxOssiaNode& child = nodes[h];
+    if (pattern.matchesSegment(segment, tree.paths.name(child.path), tree.paths.nameLength(child.path)))
+      selectNodes(child, pattern, i + 1, selected);
+  }
+}
+
+ofxOssiaSnapshot ofxOscQueryServer::snapshot()
+{
+  ofxOssiaSnapshot snapshot;
+  for (ofxOssiaNode& node : nodes)
+    if (node.ops) (node.*node.ops->capture)(snapshot);
+  return snapshot;
+}
+
+std::size_t ofxOscQueryServer::recall(const ofxOssiaSnapshot& snapshot, bool batched)
+{
+  // when batched, changes are only marked, to be published by the next flush
+  bool coalescing = tree.outbound.isCoalescing();
+  if (batched) tree.outbound.setCoalescing(true);
 
+  std::size_t changed = 0;
+  for (const auto& column : snapshot.getColumns()){
+    if (!column) continue;
+    for (std::size_t i = 0; i < column->handles.size(); ++i){
+      // skipping the nodes removed since, even if their handle has been reused
+      ofxOssiaNode* node = nodes.get(column->handles[i], column->generations[i]);
+      if (node && node->ops && (node->*node->ops->recall)(*column, i)) ++changed;
+    }
+  }
+
+  tree.outbound.setCoalescing(coalescing);
+  return changed;
+}
+
+bool ofxOscQueryServer::saveSnapshot(const ofxOssiaSnapshot& snapshot, const std::string& file)
+{
+  std::ofstream out(ofToDataPath(file), std::ios::binary);
+  if (!out){
+    ofLogWarning("ofxOscQueryServer") << "could not write snapshot " << file;
+    return false;
+  }
+
+  std::vector<const ofxOssiaSnapshot::AbstractColumn*> columns;
+  for (const auto& column : snapshot.getColumns())
+    if (column) columns.push_back(column.get());
+
+  out.write(snapshotMagic, sizeof(snapshotMagic));
+  writeRaw(out, snapshotVersion);
+  writeRaw(out, std::uint32_t(columns.size()));
+
+  std::ostringstream values;
+  for (const auto* column : columns){
+    ofxOssiaSnapshot::writeString(out, column->typeName());
+    writeRaw(out, std::uint32_t(column->handles.size()));
+    for (std::size_t i = 0; i < column->handles.size(); ++i){
+      ofxOssiaNode* node = nodes.get(column->handles[i], column->generations[i]);
+      ofxOssiaSnapshot::writeString(out, node ? node->getPath() : std::string());
+    }
+
+    values.str("");
+    if (!column->writeValues(values))
+      ofLogWarning("ofxOscQueryServer") << "values of type " << column->typeName() << " can't be saved";
+    std::string bytes = values.str();
+    writeRaw(out, std::uint64_t(bytes.size()));
+    out.write(bytes.data(), bytes.size());
+  }
+  return bool(out);
+}
+
+bool ofxOscQueryServer::loadSnapshot(ofxOssiaSnapshot& snapshot, const std::string& file)
+{
+  snapshot.clear();
+  std::ifstream in(ofToDataPath(file), std::ios::binary | std::ios::ate);
+  std::streamoff length = in.tellg();
+  in.seekg(0);
+  char magic[sizeof(snapshotMagic)];
+  std::uint32_t version = 0, columnCount = 0;
+  if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, snapshotMagic, sizeof(magic)) != 0
+      || !readRaw(in, version) || version < 1 || version > snapshotVersion || !readRaw(in, columnCount)){
+    ofLogWarning("ofxOscQueryServer") << "could not read snapshot " << file;
+    return false;
+  }
+
+  // counts and lengths are checked against what is left of the file, before allocating anything
+  auto remaining = [&]{ return std::uint64_t(length - in.tellg()); };
+  auto corrupted = [&]{
+    snapshot.clear();
+    ofLogWarning("ofxOscQueryServer") << "snapshot " << file << " is corrupted";
+    return false;
+  };
+
+  // a column takes at least the lengths of its type's name, its number of values and their size
+  if (columnCount > remaining() / (2 * sizeof(std::uint32_t) + sizeof(std::uint64_t))) return corrupted();
+  for (std::uint32_t c = 0; c < columnCount; ++c){
+    std::string typeName;
+    std::uint32_t count = 0;
+    if (!ofxOssiaSnapshot::readString(in, typeName, remaining()) || !readRaw(in, count)
+        || count > remaining() / sizeof(std::uint32_t)) return corrupted();
+
+    std::unique_ptr<ofxOssiaSnapshot::AbstractColumn> column;
+    for (const auto& entry : typeRegistry())
+      if (typeName == (version == 1 ? entry.second.valueType->name() : *entry.second.typeName))
+        column = entry.second.createColumn();
+
+    // nodes that can't be found (anymore) are kept as invalid handles
+    std::vector<std::uint32_t> handles(count, std::uint32_t(ofxOssiaNode::none)), generations(count, 0);
+    for (std::uint32_t i = 0; i < count; ++i){
+      std::string path;
+      if (!ofxOssiaSnapshot::readString(in, path, remaining())) return corrupted();
+      ofxOssiaNode* node = findPath(path.c_str(), path.size());
+      if (node){ handles[i] = node->handle; generations[i] = node->generation; }
+    }
+
+    std::uint64_t size = 0;
+    if (!readRaw(in, size) || size > remaining()) return corrupted();
+    if (!column || size == 0){
+      if (!column) ofLogWarning("ofxOscQueryServer") << "snapshot " << file << ": unknown type " << typeName;
+      in.seekg(size, std::ios::cur);
+      continue;
+    }
+    if (!column->readValues(in, count, std::size_t(size))) return corrupted();
+    column->handles = std::move(handles);
+    column->generations = std::move(generations);
+    snapshot.add(std::move(column));
+  }
+  return true;
+}
+
+bool ofxOscQueryServer::startRecording(const std::string& file, std::size_t capacity)
+{
+  if (!tree.recorder.open(ofToDataPath(file), capacity)) return false;
+  for (ofxOssiaNode& node : nodes) declareNode(node);
+  return true;
+}
+
+void ofxOscQueryServer::declareNode(ofxOssiaNode& node)
+{
+  if (node.ops) tree.recorder.declare(node.handle, node.ops->typeName->c_str(), node.getPath());
+}
+
+void ofxOscQueryServer::setLazy(ofParameterGroup& group, bool lazy)
+{
+  if (lazy){
+    if (!isMarkedLazy(group)) lazyMarks.push_back(group.newReference());
+    // already exposed: collapsed right away
+    ofxOssiaNode* node = findParam(group);
+    if (node && !lazyGroups.count(node->handle)){
+      ofxOssiaAttributes attributes;
+      captureAttributes(*node, attributes);
+      while (node->firstChild != ofxOssiaNode::none) removeNode(nodes[node->firstChild]);
+      makeLazy(*node);
+      lazyGroups[node->handle]->attributes = std::move(attributes);
+    }
+    return;
+  }
+
+  lazyMarks.erase(std::remove_if(lazyMarks.begin(), lazyMarks.end(),
+    [&](const std::shared_ptr<ofAbstractParameter>& mark){ return mark->isReferenceTo(group); }), lazyMarks.end());
+  LazyGroup* found = findLazy(group);
+  if (!found) return;
+  materialize(*found);
+
+  // its nodes now belong to the lazy group holding it, if any
+  ofxOssiaNode& node = nodes[found->handle];
+  ofxOssiaNode* holder = node.lazyGroup.load();
+  std::vector<std::uint32_t> pending{node.firstChild};
+  while (!pending.empty()){
+    std::uint32_t h = pending.back();
+    pending.pop_back();
+    if (h == ofxOssiaNode::none) continue;
+    ofxOssiaNode& child = nodes[h];
+    child.lazyGroup = holder;
+    pending.push_back(child.nextSibling);
+    if (!lazyGroups.count(h)) pending.push_back(child.firstChild);
+  }
+  removeLazyGroup(node);
+  tree.namespaceChanged = true;
+}
+
+bool ofxOscQueryServer::materialize(ofParameterGroup& group)
+{
+  LazyGroup* lazy = findLazy(group);
+  if (!lazy) return false;
+  materialize(*lazy);
+  return true;
+}
+
+bool ofxOscQueryServer::isMaterialized(ofParameterGroup& group)
+{
+  ofxOssiaNode* node = findParam(group);
+  if (!node) return false;
+  auto lazy = lazyGroups.find(node->handle);
+  return lazy == lazyGroups.end() || lazy->second->materialized;
+}
+
+void ofxOscQueryServer::setLazyCapacity(std::size_t capacity)
+{
+  // groups beyond are collapsed by the next update()
+  lazyCapacity = capacity;
+}
+
+bool ofxOscQueryServer::isMarkedLazy(ofParameterGroup& group)
+{
+  for (const auto& mark : lazyMarks)
+    if (mark->isReferenceTo(group)) return true;
+  return false;
+}
+
+ofxOscQueryServer::LazyGroup* ofxOscQueryServer::findLazy(ofParameterGroup& group)
+{
+  // the group might be within another lazy group
+  ofxOssiaNode* node = find(group);
+  if (!node) return nullptr;
+  auto lazy = lazyGroups.find(node->handle);
+  return lazy != lazyGroups.end() ? lazy->second.get() : nullptr;
+}
+
+void ofxOscQueryServer::removeLazyGroup(ofxOssiaNode& node)
+{
+  auto found = lazyGroups.find(node.handle);
+  if (found == lazyGroups.end()) return;
+  LazyGroup& lazy = *found->second;
+  // "_expand" may be being set from the network thread: its callback goes first
+  lazy.expand.remove_value_callback(lazy.callback);
+  lazy.callback = opp::callback_index();
+  node.currentNode.remove_child(lazy.expand.get_name());
+  lazyGroups.erase(found);
+}
+
+void ofxOscQueryServer::makeLazy(ofxOssiaNode& node)
+{
+  std::unique_ptr<LazyGroup> lazy(new LazyGroup);
+  lazy->server = this;
+  lazy->handle = node.handle;
+  lazy->expand = node.currentNode.create_impulse("_expand");
+  lazy->expand.set_access(opp::access_mode::Set);
+  lazy->callback = lazy->expand.set_value_callback([](void* context, const opp::value&){
+    // from the network thread: materialized by the next update()
+    LazyGroup* self = static_cast<LazyGroup*>(context);
+    self->requested = true;
+    self->server->lazyRequested = true;
+  }, lazy.get());
+  lazyGroups[node.handle] = std::move(lazy);
+  tree.namespaceChanged = true;
+  // its parameters are now found by materializing it
+  unexposedParams.clear();
+}
+
+void ofxOscQueryServer::materialize(LazyGroup& lazy)
+{
+  ofxOssiaNode& node = nodes[lazy.handle];
+  node.touch();
+  if (lazy.materialized) return;
+
+  buildTreeFrom(static_cast<ofParameterGroup&>(*node.ofParam), node);
+  lazy.materialized = true;
+
+  // The nodes created use this group (those of nested lazy groups, once materialized, their own)
+  std::vector<std::uint32_t> pending{node.firstChild};
+  while (!pending.empty()){
+    std::uint32_t h = pending.back();
+    pending.pop_back();
+    if (h == ofxOssiaNode::none) continue;
+    ofxOssiaNode& child = nodes[h];
+    child.lazyGroup = &node;
+    pending.push_back(child.nextSibling);
+    if (!lazyGroups.count(h)) pending.push_back(child.firstChild);
+  }
+
+  // the attributes set while it was collapsed
+  if (lazy.attributes.size()){
+    ofxOssiaAttributes attributes;
+    std::swap(attributes, lazy.attributes);
+    applyEntries(attributes.entries, node);
+  }
+}
+
+void ofxOscQueryServer::collapse(LazyGroup& lazy)
+{
+  ofxOssiaNode& node = nodes[lazy.handle];
+  captureAttributes(node, lazy.attributes);
+  while (node.firstChild != ofxOssiaNode::none) removeNode(nodes[node.firstChild]);
+  lazy.materialized = false;
+}
+
+void ofxOscQueryServer::captureAttributes(ofxOssiaNode& group, ofxOssiaAttributes& attributes)
+{
+  std::vector<std::uint32_t> pending{group.firstChild};
+  while (!pending.empty()){
+    std::uint32_t h = pending.back();
+    pending.pop_back();
+    if (h == ofxOssiaNode::none) continue;
+    ofxOssiaNode& node = nodes[h];
+    pending.push_back(node.nextSibling);
+    // collapsed nested groups already hold the attributes of their nodes
+    auto lazy = lazyGroups.find(h);
+    if (lazy == lazyGroups.end() || lazy->second->materialized) pending.push_back(node.firstChild);
+    else for (const auto& entry : lazy->second->attributes.entries) attributes.entries.push_back(entry);
+    if (!node.edited) continue;
+
+    // those that differ from the ones of a new node
+    ofxOssiaAttributes::Entry& entry = attributes[tree.paths.get(node.path)];
+    std::string description = node.getDescription();
+    std::vector<std::string> tags = node.getTags();
+    if (!description.empty()) entry.setDescription(description);
+    if (!tags.empty())        entry.setTags(tags);
+    if (node.getHidden())     entry.setHidden(true);
+    if (node.ops){
+      int access = node.getAccess();
+      std::string clipMode = node.getClipMode(), unit = node.getUnit();
+      if (access == 1 || access == 2)  entry.setAccess(access == 1 ? "GET" : "SET");
+      if (clipMode != "none")          entry.setClipMode(clipMode);
+      if (!unit.empty())               entry.setUnit(unit);
+      if (node.getCritical())          entry.setCritical(true);
+      if (node.getDisabled())          entry.setDisabled(true);
+      if (node.getMuted())             entry.setMuted(true);
+      if (node.getRepetitionFilter())  entry.setRepetitionFilter(true);
+      if (node.getPriority() != 0)     entry.setPriority(node.getPriority());
+      if (node.getRefreshRate() != 0)  entry.setRefreshRate(node.getRefreshRate());
+      if (node.getValueStepSize() != 0) entry.setValueStepSize(node.getValueStepSize());
+    }
+    if (entry.empty()) attributes.entries.pop_back();
+  }
+}
+
+void ofxOscQueryServer::enforceLazyCapacity()
+{
+  if (lazyCapacity == 0) return;
+
+  // A group is used whenever a nested group is (see ofxOssiaNode::touch()):
+  // nested groups go first, their holder never being older
+  for (;;){
+    std::size_t materialized = 0;
+    LazyGroup* oldest = nullptr;
+    std::uint64_t oldestUse = 0;
+    for (auto& entry : lazyGroups){
+      LazyGroup& lazy = *entry.second;
+      if (!lazy.materialized) continue;
+      ++materialized;
+      ofxOssiaNode& node = nodes[lazy.handle];
+      std::uint64_t lastUse = node.lastUse.load(std::memory_order_relaxed);
+      if (!oldest || lastUse < oldestUse || (lastUse == oldestUse && node.lazyGroup.load() == &nodes[oldest->handle])){
+        oldest = &lazy;
+        oldestUse = lastUse;
+      }
+    }
+    if (materialized <= lazyCapacity || !oldest) return;
+    collapse(*oldest);
+  }
+}
+
+void ofxOscQueryServer::handleLazyRequests()
+{
+  if (!lazyRequested.exchange(false)) return;
+  std::vector<LazyGroup*> requested;
+  for (auto& entry : lazyGroups)
+    // not for destroyed instances
+    if (entry.second->requested.exchange(false) && !nodes[entry.first].pooled.load())
+      requested.push_back(entry.second.get());
+  // materializing may add (nested) lazy groups
+  for (LazyGroup* lazy : requested) materialize(*lazy);
+}
+
+bool ofxOscQueryServer::materializeFor(const char* targetPath, std::size_t length)
+{
+  trimPath(targetPath, length);
+  for (auto& entry : lazyGroups){
+    LazyGroup& lazy = *entry.second;
+    if (lazy.materialized) continue;
+    ofxOssiaNode& node = nodes[lazy.handle];
+    tree.paths.get(node.path, pathScratch);
+    const char* path = pathScratch.data();
+    std::size_t pathLength = pathScratch.size();
+    trimPath(path, pathLength);
+    bool within = pathLength == 0
+      || (length > pathLength && targetPath[pathLength] == '/' && std::memcmp(path, targetPath, pathLength) == 0);
+    if (!within) continue;
+    materialize(lazy);
+    return true;
+  }
+  return false;
+}
+
+bool ofxOscQueryServer::materializeFor(ofAbstractParameter& param)
+{
+  for (auto& entry : lazyGroups){
+    LazyGroup& lazy = *entry.second;
+    if (lazy.materialized || !contains(static_cast<ofParameterGroup&>(*nodes[lazy.handle].ofParam), param)) continue;
+    materialize(lazy);
+    return true;
+  }
+  return false;
+}
+
+void ofxOscQueryServer::setTransactional(ofParameterGroup& group, bool transactional, bool notifyParameters)
+{
+  ofxOssiaNode* node = findParam(group);
+  if (!node){
+    ofLogWarning("ofxOscQueryServer") << "setTransactional: " << group.getName() << " is not exposed by this server";
+    return;
+  }
+  auto found = transactions.find(node->handle);
+
+  if (transactional){
+    if (found != transactions.end()){
+      found->second->notifyParameters = notifyParameters;
+      return;
+    }
+    std::unique_ptr<Transaction> transaction(new Transaction);
+    transaction->server = this;
+    transaction->handle = node->handle;
+    transaction->notifyParameters = notifyParameters;
+    transaction->commit = node->currentNode.create_impulse("_commit");
+    transaction->commit.set_access(opp::access_mode::Set);
+    transaction->callback = transaction->commit.set_value_callback([](void* context, const opp::value&){
+      // from the network thread: committed by the next update()
+      Transaction* self = static_cast<Transaction*>(context);
+      self->requested = true;
+      self->server->commitRequested = true;
+    }, transaction.get());
+    stageNodes(*node, transaction->staged.get());
+    transactions[node->handle] = std::move(transaction);
+    tree.namespaceChanged = true;
+    return;
+  }
+
+  if (found == transactions.end()) return;
+  // back to the enclosing transaction, if any, then the values staged so far are applied
+  ofxOssiaNode* parent = nodes.get(node->parent);
+  stageNodes(*node, parent ? parent->staged.load() : nullptr);
+  commit(*found->second);
+  removeTransaction(*node);
+  tree.namespaceChanged = true;
+}
+
+void ofxOscQueryServer::removeTransaction(ofxOssiaNode& node)
+{
+  auto found = transactions.find(node.handle);
+  if (found == transactions.end()) return;
+  Transaction& transaction = *found->second;
+  // "_commit" may be being set from the network thread: its callback goes first
+  transaction.commit.remove_value_callback(transaction.callback);
+  transaction.callback = opp::callback_index();
+  node.currentNode.remove_child(transaction.commit.get_name());
+  // callbacks may still be staging into it, though none of the nodes refers to it anymore
+  retiredStages.push_back(std::move(transaction.staged));
+  transactions.erase(found);
+}
+
+void ofxOscQueryServer::reclaimStagedUpdates()
+{
+  // callbacks starting from now find the nodes' current transaction, if any
+  if (retiredStages.empty() || tree.staging.load() != 0) return;
+  // values staged as their transaction was removed are applied on their own
+  for (auto& staged : retiredStages){
+    staged->take(stagedNodes);
+    for (std::uint32_t h : stagedNodes){
+      ofxOssiaNode* node = nodes.get(h);
+      if (!node || !node->slot) continue;
+      node->slot->staged.store(false);
+      node->slot->apply(true);
+    }
+  }
+  retiredStages.clear();
+}
+
+std::size_t ofxOscQueryServer::commitTransaction(ofParameterGroup& group)
+{
+  Transaction* transaction = findTransaction(group);
+  return transaction ? commit(*transaction) : 0;
+}
+
+std::size_t ofxOscQueryServer::cancelTransaction(ofParameterGroup& group)
+{
+  Transaction* transaction = findTransaction(group);
+  return transaction ? cancel(*transaction) : 0;
+}
+
+ofxOscQueryServer::Transaction* ofxOscQueryServer::findTransaction(ofParameterGroup& group)
+{
+  ofxOssiaNode* node = findParam(group);
+  if (!node) return nullptr;
+  auto transaction = transactions.find(node->handle);
+  return transaction != transactions.end() ? transaction->second.get() : nullptr;
+}
+
+void ofxOscQueryServer::stageNodes(ofxOssiaNode& node, ofxOssiaStagedUpdates* staged)
+{
+  node.staged = staged;
+  for (std::uint32_t h = node.firstChild; h != ofxOssiaNode::none; h = nodes[h].nextSibling)
+    if (!transactions.count(h)) stageNodes(nodes[h], staged);
+}
+
+std::size_t ofxOscQueryServer::commit(Transaction& transaction)
+{
+  transaction.staged->take(stagedNodes);
+  std::size_t changed = 0;
+  for (std::uint32_t h : stagedNodes){
+    // nodes removed since they received their value are skipped
+    ofxOssiaNode* node = nodes.get(h);
+    if (!node || !node->slot) continue;
+    // cleared first, so that a value received while we apply this one is staged again
+    node->slot->staged.store(false);
+    if (node->slot->apply(transaction.notifyParameters)) ++changed;
+  }
+  if (tree.metrics.isEnabled()) tree.metrics.applied += changed;
+  if (changed && transactionListener)
+    transactionListener(static_cast<ofParameterGroup&>(*nodes[transaction.handle].ofParam), changed);
+  return changed;
+}
+
+std::size_t ofxOscQueryServer::cancel(Transaction& transaction)
+{
+  transaction.staged->take(stagedNodes);
+  std::size_t dropped = 0;
+  for (std::uint32_t h : stagedNodes){
+    ofxOssiaNode* node = nodes.get(h);
+    if (!node || !node->slot) continue;
+    node->slot->staged.store(false);
+    node->slot->discard();
+    // the ossia node holds the value received: back to the ofParameter's
+    (node->*node->ops->publish)();
+    ++dropped;
+  }
+  return dropped;
+}
+
+void ofxOscQueryServer::handleCommitRequests()
+{
+  if (!commitRequested.exchange(false)) return;
+  std::vector<std::uint32_t> requested;
+  for (auto& entry : transactions)
+    if (entry.second->requested.exchange(false)) requested.push_back(entry.first);
+  // the transaction listener may change the transactional groups
+  for (std::uint32_t h : requested){
+    auto transaction = transactions.find(h);
+    if (transaction != transactions.end()) commit(*transaction->second);
+  }
+}
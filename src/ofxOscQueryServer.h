@@ -6,15 +6,25 @@
 #undef status
 #undef None
 #include <ossia-cpp98.hpp>
+#include "ofxOscQueryEngine.h"
 #include "ofxOssiaNode.h"
 #include "ofxOssiaTypes.h"
+#include "ofxOssiaUpdateQueue.h"
+#include "ofxOssiaDirtySet.h"
+#include "ofxOssiaNodeStore.h"
+#include "ofxOssiaMetrics.h"
+#include "ofxOssiaSnapshot.h"
+#include "ofxOssiaRecorder.h"
+#include "ofxOssiaInstances.h"
+#include "ofxOssiaAttributes.h"
+#include "ofxOssiaSelection.h"
 #include <types/ofParameter.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
-#include <list>
-
-#define DEFAULT_OSC 1234
-#define DEFAULT_WS  5678
-#define DEFAULT_NAME "ofxOscQuery"
+#include <typeindex>
+#include <unordered_map>
 
 class ofxOscQueryServer {
 
@@ -23,17 +33,30 @@ class ofxOscQueryServer {
     ofxOscQueryServer(int localportOSC = DEFAULT_OSC,
                       int localPortWS  = DEFAULT_WS,
                       std::string name = DEFAULT_NAME):
-      OSCport(localportOSC), WSport(localPortWS), serverName(name),
-      device(name, localportOSC, localPortWS){
+      engine(std::make_shared<ofxOscQueryEngine>(name, localportOSC, localPortWS)),
+      serverName(name), OSCport(localportOSC), WSport(localPortWS){
+    }
+
+    /**
+     * Shared network engine (see ofxOscQueryEngine::shared()):
+     * the server is exposed under its own node at the root of the engine's device,
+     * named after the ParameterGroup (or the name given to setup()),
+     * through the engine's ports and threads, along with the other servers sharing it.
+     * Paths (find(), snapshots...) stay relative to the server
+     **/
+    ofxOscQueryServer(std::shared_ptr<ofxOscQueryEngine> sharedEngine):
+      engine(sharedEngine), serverName(DEFAULT_NAME),
+      OSCport(sharedEngine->getOSCPort()), WSport(sharedEngine->getWSPort()), sharedEngine(true){
     }
     
-    ~ofxOscQueryServer() = default;
+    ~ofxOscQueryServer();
 
     /**
      * setup for ossia Device:
      * Create a root node at the specified ParameterGroup
      * with optional specific ports for OSC and WS (default 1234 & 5678)
      * and optionnal device name  (defaults to the ParameterGroup's name)
+     * With a shared engine, the ports are those of the engine, and the name that of the server's node
      **/
     void setup(ofParameterGroup & group, int localportOSC = DEFAULT_OSC, int localPortWS = DEFAULT_WS, std::string localname = "");
 
@@ -43,29 +66,452 @@ class ofxOscQueryServer {
      **/
     void buildTreeFrom(ofParameterGroup& group, ofxOssiaNode& node);
 
+    /**
+     * Dynamic namespace:
+     * setup() exposes the ofParameterGroup as it is at that time.
+     * Parameters and groups added or removed afterwards can be exposed or withdrawn
+     * one by one - they are also added to (or removed from) their parent group if needed -
+     * or all at once, by sync()ing the tree with its ofParameterGroup (or only one of its sub-groups):
+     * only the nodes of the parameters that have been added or removed are then created or removed
+     **/
+    ofxOssiaNode* addParameter(ofAbstractParameter& param, ofParameterGroup& parent);
+    ofxOssiaNode* addGroup(ofParameterGroup& group, ofParameterGroup& parent);
+    bool removeParameter(ofAbstractParameter& param);
+    bool removeGroup(ofParameterGroup& group);
+    void sync();
+    void sync(ofParameterGroup& group);
+
+    /**
+     * Lazy groups:
+     * The group is only exposed as its own node, with an "_expand" impulse:
+     * the nodes of its parameters (and their listeners) are created once it is materialized,
+     * when a client sends "_expand" (handled by update()), when one of them is looked up
+     * with find() or operator[], or by materialize().
+     * At most 'capacity' lazy groups are materialized at once (0 for no limit):
+     * beyond, the least recently used ones - materialized, looked up or having received
+     * a value - are collapsed back to their group node by the next update(), so that the
+     * nodes found until then stay valid. The attributes set to their nodes are kept,
+     * and set again once they're materialized.
+     * Groups can be made lazy before setup() (or addGroup()), or once exposed
+     **/
+    void setLazy(ofParameterGroup& group, bool lazy = true);
+    bool materialize(ofParameterGroup& group);
+    bool isMaterialized(ofParameterGroup& group);
+    void setLazyCapacity(std::size_t capacity);
+    std::size_t getLazyCapacity(){ return lazyCapacity; }
+
+    /**
+     * Instances:
+     * Exposes instances of a prototype group in 'parent' - "voice.1", "voice.2"... -
+     * created and destroyed by the application or by clients (see ofxOssiaInstances),
+     * between 'min' and 'max' of them, the first 'min' ones being created right away.
+     * Destroyed instances are pooled - hidden, disabled, and ignoring the values still received -
+     * and reused by the next creations.
+     * Returns nullptr if the parent group is not exposed by this server
+     **/
+    ofxOssiaInstances* addInstances(ofParameterGroup& prototype, ofParameterGroup& parent, int min = 0, int max = 64);
+    // Removes all the instances (and their nodes), and destroys the ofxOssiaInstances
+    void removeInstances(ofxOssiaInstances& instances);
+
+    /**
+     * Deferred updates:
+     * By default, values received from the network are applied to the ofParameters
+     * right away, from libossia's network thread.
+     * Once deferred, they are queued instead (keeping only the latest value
+     * received for each node), and applied from the main thread by update()
+     * Should be enabled before setup(), the capacity being the size of the queue
+     **/
+    void setDeferredUpdates(bool deferred, std::size_t capacity = 4096);
+    bool getDeferredUpdates(){ return tree.inbound.isDeferred(); }
+
+    /**
+     * Transactions:
+     * Values received for the parameters of a transactional group (sub-groups included)
+     * are staged rather than applied, until the transaction is committed: by a client sending
+     * "_commit" to the group (e.g. at the end of the OSC bundle holding the values),
+     * handled by update(), or by commitTransaction() (e.g. once per frame).
+     * The staged values are then applied together, from the main thread, without notifying
+     * the listeners of the parameters (unless 'notifyParameters', e.g. for GUIs): the transaction
+     * listener is called once instead, with the group and the number of parameters changed.
+     * cancelTransaction() drops the staged values, and publishes back those of the parameters
+     **/
+    void setTransactional(ofParameterGroup& group, bool transactional = true, bool notifyParameters = false);
+    // returns the number of parameters that have been changed
+    std::size_t commitTransaction(ofParameterGroup& group);
+    // returns the number of values dropped
+    std::size_t cancelTransaction(ofParameterGroup& group);
+    void setTransactionListener(std::function<void(ofParameterGroup& group, std::size_t changed)> listener)
+      { transactionListener = std::move(listener); }
+
+    /**
+     * Coalesced output:
+     * By default, every change of an ofParameter is published right away.
+     * When coalescing, changes made by the application only mark their node,
+     * and the latest value of each marked node is published by flush().
+     * update() flushes at most 'rate' times per second, or on every call when rate is 0
+     **/
+    void setCoalescedOutput(bool coalesce, float rate = 0);
+    bool getCoalescedOutput(){ return tree.outbound.isCoalescing(); }
+
+    /**
+     * Output scheduling:
+     * Nodes with a refresh rate (see ofxOssiaNode::setRefreshRate()) publish their changes
+     * at most once per period: the latest change is kept, and published by update() once due.
+     * A budget limits the number of nodes published by each flush; when there are more
+     * changes pending, those of the nodes with the highest priority are published first,
+     * and the others are kept for the next flush. 0 means no limit
+     **/
+    void setOutputBudget(std::size_t maxNodesPerFlush){ outputBudget = maxNodesPerFlush; }
+    std::size_t getOutputBudget(){ return outputBudget; }
+
+    // To be called from ofApp::update(), when updates are deferred, output is coalesced or scheduled
+    void update();
+    // Applies all values received since last call, returns the number of nodes updated
+    std::size_t applyPendingUpdates();
+    // Publishes the changes made since last call, returns the number of nodes published
+    std::size_t flush();
+
+    /**
+     * Metrics:
+     * Once enabled, each node counts the values it receives and sends
+     * (see ofxOssiaNode::getMetrics()), and one out of 'sampling' value callbacks
+     * and publications is timed.
+     * When exposed, the server's metrics are also published as read-only nodes
+     * under /_stats, refreshed by update() once per second
+     **/
+    void setMetrics(bool enabled, bool exposed = false, unsigned sampling = 64);
+    const ofxOssiaServerMetrics& getMetrics(){ return tree.metrics; }
+
+    /**
+     * Snapshots:
+     * snapshot() captures the values of all parameters, by type, and recall() sets back
+     * only those that differ from the current values - optionally publishing them
+     * by the next flush (see update()) rather than one by one.
+     * A snapshot refers to the nodes of the server it has been taken from (those removed since
+     * being skipped, even if their handle has been reused): it can be saved to a binary file, and loaded back (by path) in any server
+     **/
+    ofxOssiaSnapshot snapshot();
+    // returns the number of parameters that have been changed
+    std::size_t recall(const ofxOssiaSnapshot& snapshot, bool batched = false);
+    bool saveSnapshot(const ofxOssiaSnapshot& snapshot, const std::string& file);
+    bool loadSnapshot(ofxOssiaSnapshot& snapshot, const std::string& file);
+
+    /**
+     * Attribute tables:
+     * apply() sets the attributes of a table (see ofxOssiaAttributes) to all the nodes
+     * matched by its entries, in a single pass over the tree, and returns the number of nodes
+     * changed. Parameter attributes (range, clip mode...) are skipped for groups, ranges of
+     * another type than the parameter's are ignored. The entries that may apply to the nodes
+     * of collapsed lazy groups are kept by these groups, and applied once they're materialized
+     * (the nodes changed then not being counted).
+     * The namespace listener is called once per batch of changes, with the new version
+     * of the namespace: once by apply(), and once by update() for all the other changes
+     * (attributes set one by one, nodes added or removed) since its last call
+     **/
+    std::size_t apply(const ofxOssiaAttributes& attributes);
+    void setNamespaceListener(std::function<void(std::uint64_t version)> listener){ namespaceListener = std::move(listener); }
+    std::uint64_t getNamespaceVersion(){ return namespaceVersion; }
+
+    /**
+     * Recording:
+     * Once started, the values received by the nodes and those set by the application
+     * are appended, with their time, to a log file of a fixed capacity (in bytes),
+     * mapped in memory, without slowing down the value callbacks;
+     * see ofxOssiaReplayer to play it back
+     **/
+    bool startRecording(const std::string& file, std::size_t capacity = 64 << 20);
+    void stopRecording(){ tree.recorder.close(); }
+    const ofxOssiaRecorder& getRecorder(){ return tree.recorder; }
+
+    /**
+     * Supported types:
+     * All types listed in ossia::MatchingTypes are supported by default.
+     * Other ofParameter<DataValue> can be exposed by providing
+     * a specialization of ossia::MatchingType<DataValue> and registering it
+     * with registerType<DataValue>() before calling setup()
+     **/
+    template<typename DataValue>
+    static void registerType();
+
     /**
      * Address-space utilities:
      **/
-    opp::oscquery_server& getDevice(){return device;}
+    opp::oscquery_server& getDevice(){return engine->getDevice();}
+    ofxOscQueryEngine& getEngine(){return *engine;}
+
+    ofxOssiaNode& getRootNode(){ return nodes[0];}
 
-    ofxOssiaNode& getRootNode(){ return nodes.front();}
+    // The node with a given handle (see ofxOssiaNode::getHandle()), or nullptr
+    ofxOssiaNode* getNode(std::uint32_t handle){ return nodes.get(handle);}
+    // nullptr as well if this handle is now another node's (see ofxOssiaNode::getGeneration())
+    ofxOssiaNode* getNode(std::uint32_t handle, std::uint32_t generation){ return nodes.get(handle, generation);}
 
     // Find a specific node by:
     // - path (ossia, relative to the server)
-    ofxOssiaNode& operator[](std::string targetPath);
+    ofxOssiaNode& operator[](const std::string& targetPath);
+    ofxOssiaNode& operator[](const char* targetPath);
     // - or ofParameter reference
     ofxOssiaNode& operator[](ofAbstractParameter& targetParam);
     // When no corresponding node is found, the reference to the root node
     // (aka serverName.getRootNode()) is returned
+    // (an ofParameter that isn't found is remembered as such, until nodes are added or sync() is called)
+
+    // Same lookups, but returning nullptr when no corresponding node is found
+    ofxOssiaNode* find(const std::string& targetPath);
+    ofxOssiaNode* find(const char* targetPath);
+    ofxOssiaNode* find(ofAbstractParameter& targetParam);
+
+    /**
+     * Pattern addressing:
+     * the nodes whose path matches a pattern (see ofxOssiaPathPattern), e.g. "/renderer?/size"
+     * or "/voice.{1,2,3}/gain", in the order of the tree: the literal start of the pattern
+     * is looked up, and only the sub-trees matching each following name are walked.
+     * Patterns are compiled once, and kept for the next selections.
+     * As find() does, materializes the lazy groups the pattern reaches into
+     **/
+    ofxOssiaSelection select(const std::string& pattern);
 
   private:
-    opp::oscquery_server device;
+    std::shared_ptr<ofxOscQueryEngine> engine;
     std::string serverName;
     int OSCport, WSport;
-    std::list<ofxOssiaNode> nodes;
+    bool sharedEngine = false;
+    float flushRate = 0;
+    std::chrono::steady_clock::time_point lastFlush;
+    std::size_t outputBudget = 0;
+    // scratch lists of the nodes to publish, and to keep for later, by flush()
+    std::vector<std::uint32_t> dueNodes, waitingNodes;
+    // the /_stats nodes, when metrics are exposed
+    opp::node statsRoot;
+    std::vector<opp::node> statsNodes;
+    std::chrono::steady_clock::time_point lastStats;
+    std::function<void(std::uint64_t)> namespaceListener;
+    std::uint64_t namespaceVersion = 0;
+    // The server's node in a shared engine, removed once the nodes below it are
+    struct Mount {
+      ~Mount(){ if (engine) engine->unmount(node); }
+      std::shared_ptr<ofxOscQueryEngine> engine;
+      opp::node node;
+    };
+    Mount mount;
+    // declared before the nodes, which unregister from it when destroyed
+    ofxOssiaTreeContext tree;
+    ofxOssiaNodeStore<ofxOssiaNode> nodes;
+
+    // Lazy groups, by handle of their node
+    struct LazyGroup {
+      ~LazyGroup(){ if (callback) expand.remove_value_callback(callback); }
+      ofxOscQueryServer* server;
+      std::uint32_t handle;
+      opp::node expand;
+      opp::callback_index callback;
+      bool materialized = false;
+      // set by "_expand", from the network thread
+      std::atomic<bool> requested{false};
+      // while collapsed: the attributes of its nodes, set once materialized
+      ofxOssiaAttributes attributes;
+    };
+    std::unordered_map<std::uint32_t, std::unique_ptr<LazyGroup>> lazyGroups;
+    // references to the groups made lazy, exposed as such when their node is created
+    std::vector<std::shared_ptr<ofAbstractParameter>> lazyMarks;
+    std::size_t lazyCapacity = 0;
+    std::atomic<bool> lazyRequested{false};
+
+    // Transactional groups (see setTransactional()), by handle of their node
+    struct Transaction {
+      ~Transaction(){ if (callback) commit.remove_value_callback(callback); }
+      ofxOscQueryServer* server;
+      std::uint32_t handle;
+      opp::node commit;
+      opp::callback_index callback;
+      bool notifyParameters = false;
+      // outlives the transaction, until no callback can still be staging into it
+      std::unique_ptr<ofxOssiaStagedUpdates> staged{new ofxOssiaStagedUpdates};
+      // set by "_commit", from the network thread
+      std::atomic<bool> requested{false};
+    };
+    std::unordered_map<std::uint32_t, std::unique_ptr<Transaction>> transactions;
+    std::atomic<bool> commitRequested{false};
+    std::function<void(ofParameterGroup&, std::size_t)> transactionListener;
+    // scratch list of the nodes staged by a transaction
+    std::vector<std::uint32_t> stagedNodes;
+    // staged updates of the transactions removed, freed by update()
+    std::vector<std::unique_ptr<ofxOssiaStagedUpdates>> retiredStages;
+
+    // Instances (see addInstances()), and the instances they're made of, by handle of their node
+    std::vector<std::unique_ptr<ofxOssiaInstances>> instancers;
+    std::unordered_map<std::uint32_t, ofxOssiaInstances*> instanceNodes;
+    // nodes of the instances destroyed at least once, with the nodes within that have been
+    // disabled by the pool (to be enabled again once reused), by handle and generation
+    std::unordered_map<std::uint32_t, std::vector<std::pair<std::uint32_t, std::uint32_t>>> pooledNodes;
+    // scratch list of the nodes being pooled or reused
+    std::vector<std::uint32_t> pooledScratch;
+    // scratch string, into which the full path of a node is rebuilt (see ofxOssiaPathPool::get())
+    std::string pathScratch;
+
+    // Lookup indexes (of node handles), kept in sync with 'nodes':
+    // - by hash of the path, without its leading and trailing '/'
+    std::unordered_multimap<std::size_t, std::uint32_t> pathIndex;
+    // - by the object shared by all the references to the ofParameter,
+    //   so that the application's own references are found as well as the group's
+    std::unordered_multimap<const void*, std::uint32_t> paramIndex;
+    // - and the parameters looked up without being found, nor within a lazy group, until lazy groups change
+    //   (kept as references, so that their object can't be reused by another ofParameter)
+    std::unordered_map<const void*, std::shared_ptr<ofAbstractParameter>> unexposedParams;
+    // Compiled patterns (see select()), by their string
+    std::unordered_map<std::string, ofxOssiaPathPattern> compiledPatterns;
+
+    template<typename... Args>
+    ofxOssiaNode& createNode(Args&&... args){
+      if (tree.paths.isFragmented()) compactPaths();
+      ofxOssiaNode& node = nodes.emplace(std::forward<Args>(args)...);
+      node.generation = nodes.generation(node.handle);
+      linkNode(node);
+      indexNode(node);
+      if (tree.recorder.isRecording()) declareNode(node);
+      return node;
+    }
+    void linkNode(ofxOssiaNode& node);
+    void unlinkNode(ofxOssiaNode& node);
+    void indexNode(ofxOssiaNode& node);
+    void unindexNode(ofxOssiaNode& node);
+    // Rewrites the paths of all nodes into a new pool, without those of the nodes removed
+    void compactPaths();
+
+    // Creates the node of the i-th child of a group, with its sub-tree
+    ofxOssiaNode* createChild(ofxOssiaNode& node, ofParameterGroup& group, std::size_t i);
+    // Removes a node, with its sub-tree
+    void removeNode(ofxOssiaNode& node);
+    void syncNode(ofxOssiaNode& node);
+
+    // Type registry, keyed by the type of ofParameter
+    struct TypeEntry {
+      ofxOssiaNode& (*create)(ofxOscQueryServer& server, ofxOssiaNode& parent, ofAbstractParameter& param);
+      // for loading snapshots
+      const std::type_info* valueType;
+      const std::string* typeName;
+      std::unique_ptr<ofxOssiaSnapshot::AbstractColumn> (*createColumn)();
+      // for instances: a new ofParameter with the same name, value and range, and setting the value of another
+      std::shared_ptr<ofAbstractParameter> (*clone)(ofAbstractParameter& param);
+      void (*assign)(ofAbstractParameter& param, ofAbstractParameter& from);
+    };
+    static std::unordered_map<std::type_index, TypeEntry>& typeRegistry();
+
+    template<typename... DataValues>
+    static void registerTypes(ossia::TypeList<DataValues...>){
+      int expand[] = {0, (registerType<DataValues>(), 0)...};
+      (void) expand;
+    }
+
+    template<typename DataValue>
+    static ofxOssiaNode& createParameterNode(ofxOscQueryServer& server, ofxOssiaNode& parent, ofAbstractParameter& param){
+      return server.createNode(parent, static_cast<ofParameter<DataValue>&>(param));
+    }
+    template<typename DataValue>
+    static std::unique_ptr<ofxOssiaSnapshot::AbstractColumn> createColumn(){
+      return std::unique_ptr<ofxOssiaSnapshot::AbstractColumn>(new ofxOssiaSnapshot::Column<DataValue>);
+    }
+    template<typename DataValue>
+    static std::shared_ptr<ofAbstractParameter> cloneParameter(ofAbstractParameter& param){
+      ofParameter<DataValue>& p = static_cast<ofParameter<DataValue>&>(param);
+      std::shared_ptr<ofParameter<DataValue>> clone = std::make_shared<ofParameter<DataValue>>();
+      clone->set(p.getName(), p.get(), p.getMin(), p.getMax());
+      return clone;
+    }
+    template<typename DataValue>
+    static void assignParameter(ofAbstractParameter& param, ofAbstractParameter& from){
+      static_cast<ofParameter<DataValue>&>(param).set(static_cast<ofParameter<DataValue>&>(from).get());
+    }
+
+    // Instances: copies of a prototype, reset to its values, and their nodes while pooled
+    // (which ignore the values received)
+    std::shared_ptr<ofParameterGroup> cloneGroup(ofParameterGroup& prototype);
+    void resetGroup(ofParameterGroup& group, ofParameterGroup& prototype);
+    void poolNode(ofxOssiaNode& node);
+    void unpoolNode(ofxOssiaNode& node, std::shared_ptr<ofAbstractParameter> paramRef);
+
+    // Lookups, without materializing lazy groups
+    ofxOssiaNode* findPath(const char* targetPath, std::size_t length);
+    ofxOssiaNode* findParam(ofAbstractParameter& targetParam);
+    bool isUnexposed(ofAbstractParameter& targetParam);
+    ofxOssiaNode* lookupPath(const char* targetPath, std::size_t length);
+    // Pattern addressing (see select()), from the i-th segment of the pattern
+    const ofxOssiaPathPattern& compilePattern(const std::string& pattern);
+    void selectNodes(ofxOssiaNode& node, const ofxOssiaPathPattern& pattern, std::size_t i, std::vector<std::uint32_t>& selected);
+    template<typename DataValue>
+    std::size_t setValues(const std::vector<std::uint32_t>& handles, const std::vector<std::uint32_t>& generations,
+      const DataValue& value, bool batched);
+
+    bool isMarkedLazy(ofParameterGroup& group);
+    void makeLazy(ofxOssiaNode& node);
+    void materialize(LazyGroup& lazy);
+    void collapse(LazyGroup& lazy);
+    // Collapses the least recently used groups beyond the capacity (from update())
+    void enforceLazyCapacity();
+    // Adds the attributes set to the nodes below a group to a table
+    void captureAttributes(ofxOssiaNode& group, ofxOssiaAttributes& attributes);
+    // Materializes the lazy group holding a path, or a parameter, if any
+    bool materializeFor(const char* targetPath, std::size_t length);
+    bool materializeFor(ofAbstractParameter& param);
+    // Removes "_expand" and its callback, then the lazy group
+    void removeLazyGroup(ofxOssiaNode& node);
+    LazyGroup* findLazy(ofParameterGroup& group);
+    void handleLazyRequests();
+    Transaction* findTransaction(ofParameterGroup& group);
+    // Stages the values received by a node and its sub-tree (but nested transactional groups) into a transaction
+    void stageNodes(ofxOssiaNode& node, ofxOssiaStagedUpdates* staged);
+    // Removes "_commit" and its callback, then the transaction, retiring its staged updates
+    void removeTransaction(ofxOssiaNode& node);
+    // Frees the retired staged updates once no callback is staging, applying what they still hold
+    void reclaimStagedUpdates();
+    std::size_t commit(Transaction& transaction);
+    std::size_t cancel(Transaction& transaction);
+    void handleCommitRequests();
+    void publishMetrics();
+    void declareNode(ofxOssiaNode& node);
+    // Applies the entries of a table to a sub-tree, and keeps those that may apply
+    // to the nodes of its collapsed lazy groups in their tables
+    std::size_t applyEntries(const std::vector<ofxOssiaAttributes::Entry>& entries, ofxOssiaNode& from);
+    void applyEntry(ofxOssiaNode& node, const ofxOssiaAttributes::Entry& entry);
+    // Notifies the namespace listener, if the namespace changed since the last notification
+    void notifyNamespace();
     
     friend class ofxOssiaNode;
+    friend class ofxOssiaInstances;
+    friend class ofxOssiaSelection;
 
 };
 
+template<typename DataValue>
+void ofxOscQueryServer::registerType()
+{
+  typeRegistry()[std::type_index(typeid(ofParameter<DataValue>))] =
+    {&createParameterNode<DataValue>, &typeid(DataValue), &ossia::typeName<DataValue>(), &createColumn<DataValue>, &cloneParameter<DataValue>, &assignParameter<DataValue>};
+}
+
+template<typename DataValue>
+std::size_t ofxOscQueryServer::setValues(const std::vector<std::uint32_t>& handles, const std::vector<std::uint32_t>& generations,
+  const DataValue& value, bool batched)
+{
+  // when batched, changes are only marked, to be published by the next flush
+  bool coalescing = tree.outbound.isCoalescing();
+  if (batched) tree.outbound.setCoalescing(true);
+
+  std::size_t changed = 0;
+  for (std::size_t i = 0; i < handles.size(); ++i){
+    // removed since, its handle being possibly reused
+    ofxOssiaNode* node = nodes.get(handles[i], generations[i]);
+    if (!node || !node->ops || *node->ops->valueType != typeid(DataValue)) continue;
+    static_cast<ofParameter<DataValue>*>(node->ofParam)->set(value);
+    ++changed;
+  }
+
+  tree.outbound.setCoalescing(coalescing);
+  return changed;
+}
 
+template<typename DataValue>
+std::size_t ofxOssiaSelection::set(const DataValue& value, bool batched)
+{
+  return server->setValues(handles, generations, value, batched);
+}
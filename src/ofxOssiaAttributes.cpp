@@ -0,0 +1,95 @@
+#include "ofxOssiaAttributes.h"
+#include "ofJson.h"
+#include "ofLog.h"
+#include <array>
+
+namespace {
+
+// A bound read from a file: a number, a string, or an array of 2 to 4 numbers (a vector or a color)
+bool readValue(const ofJson& json, opp::value& value)
+{
+  if (json.is_number_integer()) value = opp::value(json.get<int>());
+  else if (json.is_number()) value = opp::value(json.get<float>());
+  else if (json.is_boolean()) value = opp::value(json.get<bool>());
+  else if (json.is_string()) value = opp::value(json.get<std::string>());
+  else if (json.is_array() && json.size() >= 2 && json.size() <= 4){
+    std::array<float, 4> v{};
+    for (std::size_t i = 0; i < json.size(); ++i){
+      if (!json[i].is_number()) return false;
+      v[i] = json[i].get<float>();
+    }
+    if (json.size() == 2)      value = opp::value(opp::value::vec2f{v[0], v[1]});
+    else if (json.size() == 3) value = opp::value(opp::value::vec3f{v[0], v[1], v[2]});
+    else                       value = opp::value(opp::value::vec4f{v[0], v[1], v[2], v[3]});
+  }
+  else return false;
+  return true;
+}
+
+}
+
+ofxOssiaAttributes::Entry& ofxOssiaAttributes::operator[](const std::string& pattern)
+{
+  entries.emplace_back();
+  entries.back().pattern = ofxOssiaPathPattern(pattern);
+  return entries.back();
+}
+
+ofxOssiaAttributes::Entry& ofxOssiaAttributes::operator[](ofAbstractParameter& param)
+{
+  entries.emplace_back();
+  entries.back().param = param.newReference();
+  return entries.back();
+}
+
+bool ofxOssiaAttributes::load(const std::string& file)
+{
+  ofJson json = ofLoadJson(file);
+  if (!json.is_array()){
+    ofLogWarning("ofxOssiaAttributes") << "could not load attributes from " << file << ": not an array of entries";
+    return false;
+  }
+
+  for (const ofJson& object : json){
+    auto path = object.find("path");
+    if (!object.is_object() || path == object.end() || !path->is_string()){
+      ofLogWarning("ofxOssiaAttributes") << file << ": skipping an entry without a path";
+      continue;
+    }
+    Entry& entry = (*this)[path->get<std::string>()];
+
+    for (auto it = object.begin(); it != object.end(); ++it){
+      const std::string& key = it.key();
+      const ofJson& v = it.value();
+      opp::value bound;
+      if (key == "path") continue;
+      else if (key == "DESCRIPTION" && v.is_string())     entry.setDescription(v.get<std::string>());
+      else if (key == "UNIT" && v.is_string())            entry.setUnit(v.get<std::string>());
+      else if (key == "CLIPMODE" && v.is_string())        entry.setClipMode(v.get<std::string>());
+      else if (key == "ACCESS" && v.is_string())          entry.setAccess(v.get<std::string>());
+      else if (key == "ACCESS" && v.is_number_integer()){
+        // as in OSCQuery: 1 for GET, 2 for SET, 3 for BI
+        static const char* modes[] = {"GET", "SET", "BI"};
+        int mode = v.get<int>();
+        if (mode >= 1 && mode <= 3) entry.setAccess(modes[mode - 1]);
+      }
+      else if (key == "CRITICAL" && v.is_boolean())          entry.setCritical(v.get<bool>());
+      else if (key == "HIDDEN" && v.is_boolean())            entry.setHidden(v.get<bool>());
+      else if (key == "DISABLED" && v.is_boolean())          entry.setDisabled(v.get<bool>());
+      else if (key == "MUTED" && v.is_boolean())             entry.setMuted(v.get<bool>());
+      else if (key == "REPETITION_FILTER" && v.is_boolean()) entry.setRepetitionFilter(v.get<bool>());
+      else if (key == "PRIORITY" && v.is_number())           entry.setPriority(v.get<float>());
+      else if (key == "REFRESH_RATE" && v.is_number())       entry.setRefreshRate(v.get<int>());
+      else if (key == "STEP_SIZE" && v.is_number())          entry.setValueStepSize(v.get<double>());
+      else if (key == "MIN" && readValue(v, bound))          entry.setRangeMin(bound);
+      else if (key == "MAX" && readValue(v, bound))          entry.setRangeMax(bound);
+      else if (key == "TAGS" && v.is_array()){
+        std::vector<std::string> tags;
+        for (const ofJson& tag : v) if (tag.is_string()) tags.push_back(tag.get<std::string>());
+        entry.setTags(tags);
+      }
+      else ofLogWarning("ofxOssiaAttributes") << file << ": ignoring " << key << " of " << path->get<std::string>();
+    }
+  }
+  return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <ossia-cpp98.hpp>
+#include "ofParameterGroup.h"
+#include "ofxOssiaPathPattern.h"
+#include "ofxOssiaTypes.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A table of attributes, set to the nodes of a server in one pass
+// (see ofxOscQueryServer::apply()), rather than one setter and one lookup at a time:
+//
+//   ofxOssiaAttributes attributes;
+//   attributes["/renderer/**"].setClipMode("both");
+//   attributes["/renderer/color"].setDescription("color of the circles").setTags({"color"});
+//   attributes[renderer.size].setRangeMin(0.f).setRangeMax(100.f);
+//   oscQuery.apply(attributes);
+//
+// Entries are keyed by path pattern (see ofxOssiaPathPattern) or by ofParameter,
+// and applied in their order: a later entry overrides the attributes set by an earlier one.
+// Tables can be loaded from JSON files (see load())
+
+class ofxOssiaAttributes {
+
+  public:
+
+    // The attributes set by an entry, each one only if it has been given
+    class Entry {
+
+      public:
+
+        Entry& setDescription(const std::string& v){ description = v; return with(Description); }
+        Entry& setTags(const std::vector<std::string>& v){ tags = v; return with(Tags); }
+        Entry& setUnit(const std::string& v){ unit = v; return with(Unit); }
+        // "GET"/"RO", "SET"/"WO" or "BI"/"RW"
+        Entry& setAccess(const std::string& v){ access = v; return with(Access); }
+        // "none", "both", "low", "high", "wrap" or "fold"
+        Entry& setClipMode(const std::string& v){ clipMode = v; return with(ClipMode); }
+        Entry& setCritical(bool v){ critical = v; return with(Critical); }
+        Entry& setHidden(bool v){ hidden = v; return with(Hidden); }
+        Entry& setDisabled(bool v){ disabled = v; return with(Disabled); }
+        Entry& setMuted(bool v){ muted = v; return with(Muted); }
+        Entry& setRepetitionFilter(bool v){ repetitionFilter = v; return with(RepetitionFilter); }
+        Entry& setPriority(float v){ priority = v; return with(Priority); }
+        Entry& setRefreshRate(int v){ refreshRate = v; return with(RefreshRate); }
+        Entry& setValueStepSize(double v){ valueStepSize = v; return with(ValueStepSize); }
+        // Of the type of the parameters they're set to: values of another type are ignored
+        template<typename DataValue>
+        Entry& setRangeMin(const DataValue& v){ return setRangeMin(opp::value(ossia::MatchingType<DataValue>::convert(v))); }
+        template<typename DataValue>
+        Entry& setRangeMax(const DataValue& v){ return setRangeMax(opp::value(ossia::MatchingType<DataValue>::convert(v))); }
+        Entry& setRangeMin(const opp::value& v){ rangeMin = v; return with(RangeMin); }
+        Entry& setRangeMax(const opp::value& v){ rangeMax = v; return with(RangeMax); }
+
+        bool empty() const { return fields == 0; }
+
+      private:
+
+        friend class ofxOscQueryServer;
+        friend class ofxOssiaAttributes;
+
+        enum Field : std::uint32_t {
+          Description = 1 << 0, Tags = 1 << 1, Unit = 1 << 2, Access = 1 << 3, ClipMode = 1 << 4,
+          Critical = 1 << 5, Hidden = 1 << 6, Disabled = 1 << 7, Muted = 1 << 8, RepetitionFilter = 1 << 9,
+          Priority = 1 << 10, RefreshRate = 1 << 11, ValueStepSize = 1 << 12, RangeMin = 1 << 13, RangeMax = 1 << 14
+        };
+        Entry& with(Field field){ fields |= field; return *this; }
+        bool has(Field field) const { return (fields & field) != 0; }
+
+        // the nodes it applies to
+        ofxOssiaPathPattern pattern;
+        std::shared_ptr<ofAbstractParameter> param;
+
+        std::uint32_t fields = 0;
+        std::string description, unit, access, clipMode;
+        std::vector<std::string> tags;
+        bool critical = false, hidden = false, disabled = false, muted = false, repetitionFilter = false;
+        float priority = 0;
+        int refreshRate = 0;
+        double valueStepSize = 0;
+        opp::value rangeMin, rangeMax;
+    };
+
+    // A new entry, for the nodes matching a path pattern
+    Entry& operator[](const std::string& pattern);
+    Entry& operator[](const char* pattern){ return (*this)[std::string(pattern)]; }
+    // A new entry, for the node of a parameter (or group)
+    Entry& operator[](ofAbstractParameter& param);
+
+    // Appends the entries of a JSON file: an array of objects with a "path" (pattern)
+    // and attributes named as in OSCQuery, e.g.
+    // [ {"path": "/renderer/**", "CLIPMODE": "both", "TAGS": ["renderer"]},
+    //   {"path": "/renderer/size", "DESCRIPTION": "size of the circles", "MIN": 0, "MAX": 100} ]
+    // also "UNIT", "ACCESS", "CRITICAL", "HIDDEN", "DISABLED", "MUTED", "REPETITION_FILTER",
+    // "PRIORITY", "REFRESH_RATE" and "STEP_SIZE", MIN and MAX being numbers or arrays of numbers.
+    // Returns false if the file can't be read, or isn't such an array
+    bool load(const std::string& file);
+
+    std::size_t size() const { return entries.size(); }
+    void clear(){ entries.clear(); }
+
+  private:
+
+    friend class ofxOscQueryServer;
+    std::vector<Entry> entries;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * Compact set of node ids whose ofParameter changed since the last flush
+ * One bit per node, only accessed from the main thread
+ * */
+
+class ofxOssiaDirtySet {
+
+  public:
+
+    void setCoalescing(bool c){ coalescing = c; }
+    bool isCoalescing() const { return coalescing; }
+
+    void mark(std::uint32_t id)
+    {
+      std::size_t word = id >> 6;
+      if (word >= words.size()) words.resize(word + 1, 0);
+      words[word] |= std::uint64_t(1) << (id & 63);
+      dirty = true;
+    }
+
+    bool empty() const { return !dirty; }
+
+    /**
+     * @brief calls f(id) for every marked id, in increasing order, and clears them
+     */
+    template<typename Function>
+    void consume(Function f)
+    {
+      if (!dirty) return;
+      dirty = false;
+      for (std::size_t word = 0; word < words.size(); ++word)
+      {
+        std::uint64_t bits = words[word];
+        words[word] = 0;
+        while (bits)
+        {
+          f(std::uint32_t((word << 6) + lowestBit(bits)));
+          bits &= bits - 1;
+        }
+      }
+    }
+
+  private:
+
+    static unsigned lowestBit(std::uint64_t bits)
+    {
+#if defined(_MSC_VER)
+      unsigned long i;
+      _BitScanForward64(&i, bits);
+      return unsigned(i);
+#else
+      return unsigned(__builtin_ctzll(bits));
+#endif
+    }
+
+    std::vector<std::uint64_t> words;
+    bool dirty = false;
+    bool coalescing = false;
+};
@@ -0,0 +1,164 @@
+#include "ofxOssiaInstances.h"
+#include "ofxOscQueryServer.h"
+#include <algorithm>
+
+ofxOssiaInstances::ofxOssiaInstances(ofxOscQueryServer& server, ofParameterGroup& prototype, ofParameterGroup& parent,
+                                     std::uint32_t parentHandle, opp::node parentNode, int min, int max):
+  server(server), prototype(prototype), parent(parent), name(prototype.getName()),
+  min(0), max(0), parentHandle(parentHandle), parentNode(parentNode)
+{
+  createNode = parentNode.create_int(name + "._create");
+  createNode.set_access(opp::access_mode::Set);
+  createCallback = createNode.set_value_callback([](void* context, const opp::value& v){
+    static_cast<ofxOssiaInstances*>(context)->request(true, v);
+  }, this);
+  destroyNode = parentNode.create_int(name + "._destroy");
+  destroyNode.set_access(opp::access_mode::Set);
+  destroyCallback = destroyNode.set_value_callback([](void* context, const opp::value& v){
+    static_cast<ofxOssiaInstances*>(context)->request(false, v);
+  }, this);
+  server.tree.namespaceChanged = true;
+
+  setBounds(min, max);
+}
+
+void ofxOssiaInstances::request(bool create, const opp::value& v)
+{
+  {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    requests.push_back({create, v.is_int() ? v.to_int() : 0});
+  }
+  requested = true;
+}
+
+ofxOssiaInstances::~ofxOssiaInstances()
+{
+  detach();
+}
+
+void ofxOssiaInstances::detach()
+{
+  if (!attached) return;
+  attached = false;
+  createNode.remove_value_callback(createCallback);
+  destroyNode.remove_value_callback(destroyCallback);
+  parentNode.remove_child(createNode.get_name());
+  parentNode.remove_child(destroyNode.get_name());
+  server.tree.namespaceChanged = true;
+  for (Instance& instance : instances)
+    if (instance.group) server.instanceNodes.erase(instance.handle);
+  instances.clear();
+  count = 0;
+}
+
+ofParameterGroup* ofxOssiaInstances::create(int index)
+{
+  if (!attached || int(count) >= max || index < 0 || index > max) return nullptr;
+  if (index == 0){
+    index = 1;
+    while (index <= int(instances.size()) && instances[index - 1].alive) ++index;
+  }
+  if (index > int(instances.size())) instances.resize(index);
+  Instance& instance = instances[index - 1];
+  if (instance.alive) return nullptr;
+
+  if (instance.group){
+    // reused from the pool, with the prototype's values
+    server.resetGroup(*instance.group, prototype);
+    parent.add(*instance.group);
+    server.unpoolNode(server.nodes[instance.handle], *(parent.end() - 1));
+  }
+  else {
+    std::shared_ptr<ofParameterGroup> group = server.cloneGroup(prototype);
+    group->setName(name + "." + ofToString(index));
+    ofxOssiaNode* node = server.addGroup(*group, parent);
+    if (!node) return nullptr;
+    node->setInstanceBounds(min, max);
+    instance.group = group;
+    instance.handle = node->getHandle();
+    server.instanceNodes[instance.handle] = this;
+  }
+  instance.alive = true;
+  ++count;
+  return instance.group.get();
+}
+
+bool ofxOssiaInstances::destroy(int index)
+{
+  if (!attached || int(count) <= min || index < 1 || index > int(instances.size())) return false;
+  Instance& instance = instances[index - 1];
+  if (!instance.alive) return false;
+
+  // kept in the pool, hidden and out of its parent group
+  for (std::size_t i = 0; i < parent.size(); ++i){
+    if (parent.get(i).isReferenceTo(*instance.group)){ parent.remove(i); break; }
+  }
+  server.poolNode(server.nodes[instance.handle]);
+  instance.alive = false;
+  --count;
+  return true;
+}
+
+bool ofxOssiaInstances::destroy(ofParameterGroup& group)
+{
+  for (std::size_t i = 0; i < instances.size(); ++i)
+    if (instances[i].alive && instances[i].group->isReferenceTo(group)) return destroy(int(i) + 1);
+  return false;
+}
+
+void ofxOssiaInstances::setBounds(int newMin, int newMax)
+{
+  max = std::max(newMax, 1);
+  min = std::max(0, std::min(newMin, max));
+
+  for (Instance& instance : instances)
+    if (instance.group) server.nodes[instance.handle].setInstanceBounds(min, max);
+
+  // the highest instances beyond the maximum
+  int minimum = min;
+  min = 0;
+  for (int index = int(instances.size()); index > max; --index){
+    destroy(index);
+    // no longer reusable
+    if (instances[index - 1].group) server.removeNode(server.nodes[instances[index - 1].handle]);
+  }
+  if (int(instances.size()) > max) instances.resize(max);
+  min = minimum;
+  while (attached && int(count) < min && create()) {}
+}
+
+ofParameterGroup* ofxOssiaInstances::get(int index)
+{
+  if (index < 1 || index > int(instances.size()) || !instances[index - 1].alive) return nullptr;
+  return instances[index - 1].group.get();
+}
+
+std::size_t ofxOssiaInstances::getPooled()
+{
+  return std::count_if(instances.begin(), instances.end(),
+                       [](const Instance& instance){ return instance.group && !instance.alive; });
+}
+
+void ofxOssiaInstances::forget(std::uint32_t handle)
+{
+  for (Instance& instance : instances){
+    if (!instance.group || instance.handle != handle) continue;
+    if (instance.alive) --count;
+    instance = Instance();
+    return;
+  }
+}
+
+void ofxOssiaInstances::handleRequests()
+{
+  if (!requested.exchange(false)) return;
+  {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    std::swap(requests, handledRequests);
+  }
+  for (const Request& request : handledRequests){
+    if (request.create) create(request.index);
+    else destroy(request.index);
+  }
+  handledRequests.clear();
+}
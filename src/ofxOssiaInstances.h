@@ -0,0 +1,105 @@
+#pragma once
+
+#include <ossia-cpp98.hpp>
+#include "ofParameterGroup.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ofxOscQueryServer;
+
+/*
+ * Instances of a prototype ofParameterGroup, exposed as "name.1", "name.2"...
+ * in a group of a server (see ofxOscQueryServer::addInstances()).
+ * Each instance is a copy of the prototype's parameters, with their values at the time of its creation.
+ * Destroyed instances are kept in a pool: their node is hidden and their group removed
+ * from the parent ofParameterGroup, and they're reused - nodes, ofParameters and their listeners -
+ * by the next creations, their values being reset to those of the prototype
+ * (adding the group back to its parent, and publishing its values, still allocate).
+ * Clients create and destroy instances by sending an index (0 for the lowest free one)
+ * to "name._create" and "name._destroy", handled by the server's update()
+ * */
+
+class ofxOssiaInstances {
+
+  public:
+
+    ~ofxOssiaInstances();
+    ofxOssiaInstances(const ofxOssiaInstances&) = delete;
+    ofxOssiaInstances& operator=(const ofxOssiaInstances&) = delete;
+
+    /**
+     * @brief creates (or reuses) an instance
+     * @param index from 1, or 0 for the lowest free one
+     * @return its group, or nullptr if the index is taken or beyond the maximum number of instances
+     */
+    ofParameterGroup* create(int index = 0);
+    // Fails (returns false) when the minimum number of instances is reached
+    bool destroy(int index);
+    bool destroy(ofParameterGroup& instance);
+
+    /**
+     * @brief sets how many instances can exist
+     * Instances are created up to 'min', and the highest ones beyond 'max' are destroyed.
+     * The bounds are also exposed as the instance bounds of each instance's node
+     */
+    void setBounds(int min, int max);
+    std::pair<int, int> getBounds(){ return {min, max}; }
+
+    // The instance at 'index' (from 1), or nullptr if it doesn't exist
+    ofParameterGroup* get(int index);
+    // Number of instances, and of destroyed ones kept for reuse
+    std::size_t size(){ return count; }
+    std::size_t getPooled();
+    const std::string& getName(){ return name; }
+
+  private:
+
+    friend class ofxOscQueryServer;
+
+    ofxOssiaInstances(ofxOscQueryServer& server, ofParameterGroup& prototype, ofParameterGroup& parent,
+                      std::uint32_t parentHandle, opp::node parentNode, int min, int max);
+
+    // From the network thread
+    void request(bool create, const opp::value& index);
+    // Applies the requests received from clients, from the main thread
+    void handleRequests();
+    // When the node of an instance is removed (e.g. by sync())
+    void forget(std::uint32_t handle);
+    // Withdraws the instances, when removed or when their parent group is
+    void detach();
+
+    struct Instance {
+      std::shared_ptr<ofParameterGroup> group;
+      std::uint32_t handle = 0;
+      bool alive = false;
+    };
+
+    // A request from a client: the index to create, or to destroy
+    struct Request {
+      bool create;
+      int index;
+    };
+
+    ofxOscQueryServer& server;
+    // references to the groups
+    ofParameterGroup prototype, parent;
+    std::string name;
+    int min, max;
+    // by index - 1, alive or pooled (without group when never created)
+    std::vector<Instance> instances;
+    std::size_t count = 0;
+    bool attached = true;
+
+    std::uint32_t parentHandle;
+    opp::node parentNode, createNode, destroyNode;
+    opp::callback_index createCallback, destroyCallback;
+    // set from the network thread
+    std::mutex requestMutex;
+    std::vector<Request> requests, handledRequests;
+    std::atomic<bool> requested{false};
+};
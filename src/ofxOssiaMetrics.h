@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Runtime metrics of a server and its nodes:
+ * counters of the values received and sent, and sampled durations
+ * Counters are updated from any thread, without locking
+ * */
+
+// Durations, in nanoseconds, counted by powers of two
+class ofxOssiaHistogram {
+
+  public:
+
+    static constexpr int buckets = 40; // up to ~18 minutes
+
+    void record(std::uint64_t ns)
+    {
+      int bucket = 0;
+      while (ns > 1 && bucket < buckets - 1) { ns >>= 1; ++bucket; }
+      counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const
+    {
+      std::uint64_t total = 0;
+      for (auto& c : counts) total += c.load(std::memory_order_relaxed);
+      return total;
+    }
+
+    /**
+     * @brief estimates a percentile, from the bucket it falls in
+     * @param p the percentile, between 0 and 1
+     * @return the middle of that bucket, in nanoseconds (0 if nothing has been recorded)
+     */
+    double percentile(double p) const
+    {
+      std::uint64_t total = count();
+      if (total == 0) return 0;
+      std::uint64_t rank = std::uint64_t(p * (total - 1)), seen = 0;
+      for (int bucket = 0; bucket < buckets; ++bucket)
+      {
+        seen += counts[bucket].load(std::memory_order_relaxed);
+        if (seen > rank) return bucket ? 1.5 * double(std::uint64_t(1) << bucket) : 1.;
+      }
+      return double(std::uint64_t(1) << (buckets - 1));
+    }
+
+    void reset()
+      { for (auto& c : counts) c.store(0, std::memory_order_relaxed); }
+
+  private:
+
+    std::atomic<std::uint64_t> counts[buckets] = {};
+};
+
+// Counters of one node (also used for the totals of a server)
+struct ofxOssiaNodeMetrics {
+    // values received from the network
+    std::atomic<std::uint64_t> received{0};
+    // values published to the network
+    std::atomic<std::uint64_t> sent{0};
+    // values received with a type that doesn't match the ofParameter's
+    std::atomic<std::uint64_t> mismatches{0};
+
+    void reset()
+    {
+      received.store(0, std::memory_order_relaxed);
+      sent.store(0, std::memory_order_relaxed);
+      mismatches.store(0, std::memory_order_relaxed);
+    }
+};
+
+class ofxOssiaServerMetrics {
+
+  public:
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief enables or disables the metrics
+     * @param sampling one out of 'sampling' callbacks and publications is timed
+     */
+    void setEnabled(bool e, unsigned sampling = 64)
+    {
+      samplingRate.store(sampling ? sampling : 1, std::memory_order_relaxed);
+      enabled.store(e, std::memory_order_relaxed);
+    }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Whether the current operation should be timed
+    bool sample() const
+    {
+      static thread_local unsigned counter = 0;
+      return ++counter % samplingRate.load(std::memory_order_relaxed) == 0;
+    }
+
+    void reset()
+    {
+      totals.reset();
+      applied.store(0, std::memory_order_relaxed);
+      flushed.store(0, std::memory_order_relaxed);
+      callbackTime.reset();
+      publishTime.reset();
+    }
+
+    // sum of all nodes' counters, including those that have been removed
+    ofxOssiaNodeMetrics totals;
+    // values applied by update(), when deferred
+    std::atomic<std::uint64_t> applied{0};
+    // values published by flush(), when coalesced
+    std::atomic<std::uint64_t> flushed{0};
+    // duration of the value callback, from the reception of a value to its ofParameter being set (or queued)
+    ofxOssiaHistogram callbackTime;
+    // duration of the publication of a value, from its ofParameter to the ossia node
+    ofxOssiaHistogram publishTime;
+
+  private:
+
+    std::atomic<bool> enabled{false};
+    std::atomic<unsigned> samplingRate{64};
+};
+
+/*
+ * Times a scope into a histogram, when sampled
+ * */
+
+class ofxOssiaTimer {
+
+  public:
+
+    ofxOssiaTimer(ofxOssiaHistogram& histogram, bool sampled):
+      histogram(sampled ? &histogram : nullptr)
+      { if (sampled) start = ofxOssiaServerMetrics::Clock::now(); }
+
+    ~ofxOssiaTimer()
+    {
+      if (histogram)
+        histogram->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          ofxOssiaServerMetrics::Clock::now() - start).count());
+    }
+
+  private:
+
+    ofxOssiaHistogram* histogram;
+    ofxOssiaServerMetrics::Clock::time_point start;
+};
@@ -0,0 +1,136 @@
+//
+//  ofxOssiaMorph.cpp
+//  ofxOscQuery
+//
+
+#include "ofxOssiaMorph.h"
+
+float ofxOssiaMorph::ease(Easing easing, float t)
+{
+  switch (easing){
+    case EaseIn:     return t * t;
+    case EaseOut:    return t * (2 - t);
+    case EaseInOut:  return t < 0.5f ? 2 * t * t : -1 + (4 - 2 * t) * t;
+    case Smoothstep: return t * t * (3 - 2 * t);
+    default:         return t;
+  }
+}
+
+void ofxOssiaMorph::exclude(ofAbstractParameter& param, bool e)
+{
+  if (typeid(param) == typeid(ofParameterGroup)){
+    for (auto& child : static_cast<ofParameterGroup&>(param)) exclude(*child, e);
+  }
+  ofxOssiaNode* node = server.find(param);
+  if (!node) return;
+  if (e) excluded[node->getHandle()] = node->getGeneration();
+  else   excluded.erase(node->getHandle());
+}
+
+void ofxOssiaMorph::start(const ofxOssiaSnapshot& from, const ofxOssiaSnapshot& to,
+                          float seconds, Easing e)
+{
+  stop();
+
+  tracks.clear();
+  origin.clear();
+  delta.clear();
+  addTracks(from, to, InterpolatedTypes());
+
+  // the exact target values, set once the morph ends
+  target = to;
+  target.filter([this](std::uint32_t handle, std::uint32_t generation){ return !isExcluded(handle, generation); });
+
+  easing = e;
+  duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(std::max(seconds, 0.f)));
+  startTime = std::chrono::steady_clock::now();
+  progress = 0;
+  running = true;
+
+  back.assign(origin.size(), 0);
+  ready.assign(origin.size(), 0);
+  front.assign(origin.size(), 0);
+  requested = available = quitting = false;
+  worker = std::thread(&ofxOssiaMorph::run, this);
+}
+
+void ofxOssiaMorph::stop()
+{
+  if (worker.joinable()){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quitting = true;
+    }
+    wake.notify_one();
+    worker.join();
+  }
+  running = false;
+}
+
+void ofxOssiaMorph::update()
+{
+  if (!running) return;
+
+  auto elapsed = std::chrono::steady_clock::now() - startTime;
+  progress = duration.count() > 0 ? std::min(1.f, std::chrono::duration<float>(elapsed) / std::chrono::duration<float>(duration)) : 1.f;
+  if (progress >= 1){
+    finish();
+    return;
+  }
+
+  // takes the frame computed since the last update, and asks for the next one
+  bool applying = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (available){
+      std::swap(ready, front);
+      available = false;
+      applying = true;
+    }
+    requestedTime = progress;
+    requested = true;
+  }
+  wake.notify_one();
+
+  if (applying)
+    for (auto& track : tracks) track->apply(server, front.data());
+}
+
+void ofxOssiaMorph::finish()
+{
+  stop();
+  // the last frame, computed right away so that the morph ends exactly on time
+  compute(front, 1);
+  for (auto& track : tracks) track->apply(server, front.data());
+  // then the values that can't be interpolated (and the exact values of the others)
+  server.recall(target);
+  progress = 1;
+}
+
+void ofxOssiaMorph::compute(std::vector<float>& frame, float position) const
+{
+  const std::size_t n = frame.size();
+  const float* o = origin.data();
+  const float* d = delta.data();
+  float* f = frame.data();
+  // flat loop, vectorized by the compiler
+  for (std::size_t i = 0; i < n; ++i) f[i] = o[i] + d[i] * position;
+}
+
+void ofxOssiaMorph::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;){
+    wake.wait(lock, [this]{ return requested || quitting; });
+    if (quitting) return;
+    float t = requestedTime;
+    requested = false;
+
+    lock.unlock();
+    compute(back, ease(easing, t));
+    lock.lock();
+
+    std::swap(back, ready);
+    available = true;
+  }
+}
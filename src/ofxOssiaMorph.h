@@ -0,0 +1,216 @@
+#pragma once
+
+#include "ofxOscQueryServer.h"
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/*
+ * Components of the types that can be interpolated,
+ * as floats (for integers, rounded back to the nearest)
+ * */
+
+template<typename DataValue> struct ofxOssiaComponents;
+
+template<typename DataValue, int N>
+struct ofxOssiaIndexedComponents {
+  static constexpr int count = N;
+  static void get(const DataValue& v, float* c) { for (int i = 0; i < N; ++i) c[i] = float(v[i]); }
+  static void set(DataValue& v, const float* c) { for (int i = 0; i < N; ++i) v[i] = c[i]; }
+};
+
+template<> struct ofxOssiaComponents<float> {
+  static constexpr int count = 1;
+  static void get(const float& v, float* c) { c[0] = v; }
+  static void set(float& v, const float* c) { v = c[0]; }
+};
+template<> struct ofxOssiaComponents<double> {
+  static constexpr int count = 1;
+  static void get(const double& v, float* c) { c[0] = float(v); }
+  static void set(double& v, const float* c) { v = c[0]; }
+};
+template<> struct ofxOssiaComponents<int> {
+  static constexpr int count = 1;
+  static void get(const int& v, float* c) { c[0] = float(v); }
+  static void set(int& v, const float* c) { v = int(std::lround(c[0])); }
+};
+template<> struct ofxOssiaComponents<glm::vec2> : ofxOssiaIndexedComponents<glm::vec2, 2> {};
+template<> struct ofxOssiaComponents<glm::vec3> : ofxOssiaIndexedComponents<glm::vec3, 3> {};
+template<> struct ofxOssiaComponents<glm::vec4> : ofxOssiaIndexedComponents<glm::vec4, 4> {};
+template<> struct ofxOssiaComponents<ofVec2f>   : ofxOssiaIndexedComponents<ofVec2f, 2> {};
+template<> struct ofxOssiaComponents<ofVec3f>   : ofxOssiaIndexedComponents<ofVec3f, 3> {};
+template<> struct ofxOssiaComponents<ofVec4f>   : ofxOssiaIndexedComponents<ofVec4f, 4> {};
+template<> struct ofxOssiaComponents<ofFloatColor> : ofxOssiaIndexedComponents<ofFloatColor, 4> {};
+template<> struct ofxOssiaComponents<ofColor> {
+  static constexpr int count = 4;
+  static void get(const ofColor& v, float* c) { for (int i = 0; i < 4; ++i) c[i] = v[i]; }
+  static void set(ofColor& v, const float* c)
+    { for (int i = 0; i < 4; ++i) v[i] = (unsigned char)(std::min(255.f, std::max(0.f, c[i] + 0.5f))); }
+};
+
+/*
+ * Morphs the parameters of a server from one snapshot to another:
+ * values are interpolated as flat arrays of floats, on a worker thread,
+ * and only applied to the ofParameters from update(), at frame boundaries.
+ * Values that can't be interpolated (bool, std::string...) are set when the morph ends.
+ * */
+
+class ofxOssiaMorph {
+
+  public:
+
+    enum Easing { Linear, EaseIn, EaseOut, EaseInOut, Smoothstep };
+
+    ofxOssiaMorph(ofxOscQueryServer& server): server(server) {}
+    ~ofxOssiaMorph() { stop(); }
+
+    /**
+     * @brief starts morphing from a snapshot to another
+     * @param duration in seconds
+     */
+    void start(const ofxOssiaSnapshot& from, const ofxOssiaSnapshot& to,
+               float duration, Easing easing = Linear);
+    // Morphs from the current values
+    void start(const ofxOssiaSnapshot& to, float duration, Easing easing = Linear)
+      { start(server.snapshot(), to, duration, easing); }
+
+    // Stops where it is, without setting the target values
+    void stop();
+    bool isMorphing() const { return running; }
+    // Progress of the current morph, between 0 and 1
+    float getProgress() const { return progress; }
+
+    // To be called from ofApp::update(): applies the latest frame computed
+    void update();
+
+    /**
+     * Excluded parameters are left untouched by the next morphs
+     * @brief excludes a parameter (or a whole group) from morphing
+     */
+    void exclude(ofAbstractParameter& param, bool excluded = true);
+    void clearExclusions() { excluded.clear(); }
+    bool isExcluded(std::uint32_t handle, std::uint32_t generation) const
+    {
+      auto it = excluded.find(handle);
+      return it != excluded.end() && it->second == generation;
+    }
+
+    static float ease(Easing easing, float t);
+
+  private:
+
+    // The nodes of one type, with the offset of their components in the frames
+    class AbstractTrack {
+      public:
+        virtual ~AbstractTrack() = default;
+        virtual void apply(ofxOscQueryServer& server, const float* frame) = 0;
+    };
+
+    template<typename DataValue>
+    class Track : public AbstractTrack {
+      public:
+        void apply(ofxOscQueryServer& server, const float* frame) override
+        {
+          using components = ofxOssiaComponents<DataValue>;
+          const float* c = frame + offset;
+          for (std::size_t i = 0; i < handles.size(); ++i, c += components::count)
+          {
+            // the node might have been removed since the morph started
+            if (!server.getNode(handles[i], generations[i])) continue;
+            DataValue value = params[i]->get();
+            components::set(value, c);
+            if (value != params[i]->get()) params[i]->set(value);
+          }
+        }
+        std::size_t offset = 0;
+        std::vector<std::uint32_t> handles;
+        std::vector<std::uint32_t> generations;
+        std::vector<ofParameter<DataValue>*> params;
+    };
+
+    template<typename... DataValues>
+    void addTracks(const ofxOssiaSnapshot& from, const ofxOssiaSnapshot& to, ossia::TypeList<DataValues...>)
+    {
+      int expand[] = {0, (addTrack<DataValues>(from, to), 0)...};
+      (void) expand;
+    }
+
+    template<typename DataValue>
+    void addTrack(const ofxOssiaSnapshot& from, const ofxOssiaSnapshot& to);
+
+    // The types of the values that are interpolated
+    using InterpolatedTypes = ossia::TypeList<float, int, double,
+                                              glm::vec2, glm::vec3, glm::vec4,
+                                              ofVec2f, ofVec3f, ofVec4f,
+                                              ofColor, ofFloatColor>;
+
+    // Fills a frame, for an eased position between 0 and 1
+    void compute(std::vector<float>& frame, float position) const;
+    void run();
+    void finish();
+
+    ofxOscQueryServer& server;
+    // excluded nodes, by handle, with the generation of the handle (a node then taking it isn't excluded)
+    std::unordered_map<std::uint32_t, std::uint32_t> excluded;
+
+    // current morph
+    std::vector<std::unique_ptr<AbstractTrack>> tracks;
+    std::vector<float> origin, delta;
+    ofxOssiaSnapshot target;
+    Easing easing = Linear;
+    std::chrono::steady_clock::duration duration{0};
+    std::chrono::steady_clock::time_point startTime;
+    bool running = false;
+    float progress = 0;
+
+    // frames, rotated between the worker (back), the one ready to be applied, and the applied one (front)
+    std::vector<float> back, ready, front;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    float requestedTime = 0;
+    bool requested = false, available = false, quitting = false;
+};
+
+template<typename DataValue>
+void ofxOssiaMorph::addTrack(const ofxOssiaSnapshot& from, const ofxOssiaSnapshot& to)
+{
+  using components = ofxOssiaComponents<DataValue>;
+  const ofxOssiaSnapshot::Column<DataValue>* end = to.find<DataValue>();
+  if (!end) return;
+
+  const ofxOssiaSnapshot::Column<DataValue>* begin = from.find<DataValue>();
+  std::unordered_map<std::uint32_t, std::size_t> beginIndex;
+  if (begin)
+    for (std::size_t i = 0; i < begin->handles.size(); ++i) beginIndex[begin->handles[i]] = i;
+
+  std::unique_ptr<Track<DataValue>> track(new Track<DataValue>);
+  track->offset = origin.size();
+  float a[4], b[4];
+  for (std::size_t i = 0; i < end->handles.size(); ++i)
+  {
+    std::uint32_t handle = end->handles[i];
+    ofxOssiaNode* node = server.getNode(handle, end->generations[i]);
+    if (!node || isExcluded(handle, end->generations[i])) continue;
+    auto param = dynamic_cast<ofParameter<DataValue>*>(node->getParam());
+    if (!param) continue;
+
+    // nodes missing from the first snapshot start from their current value
+    auto it = beginIndex.find(handle);
+    if (it != beginIndex.end() && begin->generations[it->second] != end->generations[i]) it = beginIndex.end();
+    components::get(it != beginIndex.end() ? begin->values[it->second] : param->get(), a);
+    components::get(end->values[i], b);
+    for (int k = 0; k < components::count; ++k)
+    {
+      origin.push_back(a[k]);
+      delta.push_back(b[k] - a[k]);
+    }
+    track->handles.push_back(handle);
+    track->generations.push_back(end->generations[i]);
+    track->params.push_back(param);
+  }
+  if (!track->handles.empty()) tracks.push_back(std::move(track));
+}
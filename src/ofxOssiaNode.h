@@ -3,7 +3,32 @@
 #include <ossia-cpp98.hpp>
 #include "ofParameterGroup.h"
 #include "ofxOssiaTypes.h"
+#include "ofxOssiaUpdateQueue.h"
+#include "ofxOssiaDirtySet.h"
+#include "ofxOssiaNodeStore.h"
+#include "ofxOssiaMetrics.h"
+#include "ofxOssiaSnapshot.h"
+#include "ofxOssiaRecorder.h"
 #include "ofxOscQueryServer.h"
+#include <algorithm>
+#include <chrono>
+
+/*
+ * State shared by all the nodes of a server
+ * */
+
+struct ofxOssiaTreeContext {
+    ofxOssiaUpdateQueue inbound;
+    ofxOssiaDirtySet outbound;
+    ofxOssiaPathPool paths;
+    ofxOssiaServerMetrics metrics;
+    ofxOssiaRecorder recorder;
+    // the namespace changed (an attribute set, a node added or removed) since the server last notified it
+    bool namespaceChanged = false;
+    // value callbacks staging into a transaction: the staged updates of a removed transaction
+    // are only freed once there are none (see ofxOscQueryServer::update())
+    std::atomic<int> staging{0};
+};
 
 /*
  * Class encapsulating ossia node, parent_node and ofAbstractParameter*
@@ -30,7 +55,21 @@ class ofxOssiaNode {
      @return this node's OSC address as a string
      */
     std::string getPath()
-        {return path;}
+        {return tree->paths.get(path);}
+
+    /**
+     @brief get this node's handle, identifying it within its server
+     @return this node's handle
+     */
+    std::uint32_t getHandle()
+        {return handle;}
+
+    /**
+     @brief get the generation of this node's handle: handles being reused once their node is removed,
+     a handle and its generation identify this node for good (see ofxOscQueryServer::getNode())
+     */
+    std::uint32_t getGeneration()
+        {return generation;}
     
     /**
      @brief get this node's ofParameter object
@@ -39,6 +78,44 @@ class ofxOssiaNode {
      ofAbstractParameter* getParam()
         {return ofParam;}
 
+    /**
+     @brief get this node's counters (only updated while the server's metrics are enabled)
+     @return a reference to this node's metrics
+     */
+    const ofxOssiaNodeMetrics& getMetrics()
+        {return metrics;}
+
+    /**
+     @brief sets a range of the elements of an array parameter (ofParameter<std::vector<Element>>),
+     the whole array being published once, as one list.
+     The elements are set on a copy of the array, then set to the ofParameter, so that its listeners are notified:
+     each call copies the whole array twice (into a scratch vector, reused by the calls from the same thread,
+     then back into the ofParameter). While coalescing (see ofxOscQueryServer::setCoalescedOutput()), the array is
+     published once by the next flush, however many ranges were set meanwhile
+     @param offset the index of the first element to set (the array grows if needed)
+     @param values the new values of the 'count' elements from offset
+     @return a reference to this node
+     */
+    template<typename Element>
+    ofxOssiaNode& setElements(std::size_t offset, const Element* values, std::size_t count){
+      auto param = dynamic_cast<ofParameter<std::vector<Element>>*>(ofParam);
+      if(!param){
+        ofLogWarning() << "ofxOssiaNode::setElements: " << getName() << " is not an array of this type";
+        return *this;
+      }
+      const std::vector<Element>& current = param->get();
+      if(offset + count <= current.size() && std::equal(values, values + count, current.begin() + offset))
+        return *this;
+      // assigning keeps the scratch vector's capacity: no allocation once it has grown to the array's size
+      static thread_local std::vector<Element> array;
+      array = current;
+      if(offset + count > array.size()) array.resize(offset + count);
+      std::copy(values, values + count, array.begin() + offset);
+      // recorded and published (or marked for the next flush) by listen()
+      param->set(array);
+      return *this;
+    }
+
     //************************************//
     //           Manage attributes        //
     //************************************//
@@ -78,7 +155,7 @@ class ofxOssiaNode {
      if      (m == 1) mode = opp::access_mode::Get;
      else if (m == 2) mode = opp::access_mode::Set;
      else if (m == 3) mode = opp::access_mode::Bi;
-     getNode().set_access(mode);
+     editNode().set_access(mode);
      return *this;
      }
      
@@ -93,7 +170,7 @@ class ofxOssiaNode {
         if      (m == "GET" || m == "RO") mode = opp::access_mode::Get;
         else if (m == "SET" || m == "WO") mode = opp::access_mode::Set;
         else if (m == "BI"  || m == "RW") mode = opp::access_mode::Bi;
-        getNode().set_access(mode);
+        editNode().set_access(mode);
         return *this;
     }
     /**
@@ -124,7 +201,7 @@ class ofxOssiaNode {
      */
     template<typename DataValue>
     ofxOssiaNode& setRangeMin(const DataValue& attrVal) {
-        getNode().set_min(ossia::MatchingType<DataValue>::convert(attrVal));
+        editNode().set_min(ossia::MatchingType<DataValue>::convert(attrVal));
         static_cast<ofParameter<DataValue>*>(ofParam)->setMin(attrVal);
         return *this;
     }
@@ -149,7 +226,7 @@ class ofxOssiaNode {
      */
     template<typename DataValue>
     ofxOssiaNode& setRangeMax(const DataValue& attrVal) {
-        getNode().set_max(ossia::MatchingType<DataValue>::convert(attrVal));
+        editNode().set_max(ossia::MatchingType<DataValue>::convert(attrVal));
         static_cast<ofParameter<DataValue>*>(ofParam)->setMax(attrVal);
         return *this;
     }
@@ -177,7 +254,7 @@ class ofxOssiaNode {
         using ossia_type = ossia::MatchingType<DataValue>;
         std::vector<opp::value> res;
         for (const auto & v : attrVals) { res.push_back(ossia_type::convert(v)); }
-        getNode().set_accepted_values(res);
+        editNode().set_accepted_values(res);
         return *this;
     }
     /**
@@ -224,7 +301,7 @@ class ofxOssiaNode {
         else if (a == "wrap") mode = opp::bounding_mode::Wrap;
         else if (a == "fold") mode = opp::bounding_mode::Fold;
         else                  mode = opp::bounding_mode::Free;
-        getNode().set_bounding(mode);
+        editNode().set_bounding(mode);
         return *this;
     }
     
@@ -262,7 +339,7 @@ class ofxOssiaNode {
      * @param v a string with this unit's name
      * @return a reference to this node
      */
-    ofxOssiaNode& setUnit(const std::string& attrVal) {getNode().set_unit(attrVal); return *this;}
+    ofxOssiaNode& setUnit(const std::string& attrVal) {editNode().set_unit(attrVal); return *this;}
     /**< @details
      *
      * - **Position**
@@ -383,7 +460,7 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setCritical(bool v) {
-        getNode().set_critical( v );
+        editNode().set_critical( v );
         return *this;
     }
     /**
@@ -404,7 +481,7 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setDescription(const std::string& attrVal)
-    {getNode().set_description(attrVal); return *this;}
+    {editNode().set_description(attrVal); return *this;}
     
     /**
      * @brief gets this node's description attribute
@@ -419,7 +496,7 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setTags(std::vector<std::string> attrVal)
-    {getNode().set_tags(attrVal); return *this; }
+    {editNode().set_tags(attrVal); return *this; }
     /**
      * @brief gets this node's tags attribute
      * @return a string with this node's tags
@@ -448,7 +525,7 @@ class ofxOssiaNode {
      */
     template<typename DataValue>
     ofxOssiaNode& setDefault(DataValue v){
-        getNode().set_default_value(ossia::MatchingType<DataValue>::convert(v));
+        editNode().set_default_value(ossia::MatchingType<DataValue>::convert(v));
         return *this;
     }
     /**
@@ -465,7 +542,7 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setRepetitionFilter(bool v){
-        getNode().set_repetition_filter( v );
+        editNode().set_repetition_filter( v );
         return *this;
     }
     /**
@@ -476,12 +553,15 @@ class ofxOssiaNode {
         { return getNode().get_repetition_filter();}
     
     /**An optional value that says how often a value should be updated.
+     * It is also enforced by the server: changes of this node's ofParameter are published
+     * at most once every v milliseconds, the latest one being published by update() once due.
      * @brief sets the refresh_rate attribute of this node's parameter
-     * @param v an int with this node's parameter's refresh_rate value
+     * @param v an int with this node's parameter's refresh_rate value, in milliseconds
      * @return a reference to this node
      */
     ofxOssiaNode& setRefreshRate(int v){
-        getNode().set_refresh_rate( v );
+        editNode().set_refresh_rate( v );
+        refreshInterval = std::chrono::milliseconds(std::max(v, 0));
         return *this;
     }
     /**
@@ -489,7 +569,8 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& unsetRefreshRate(){
-        getNode().unset_refresh_rate();
+        editNode().unset_refresh_rate();
+        refreshInterval = std::chrono::milliseconds(0);
         return *this;
     }
     /**
@@ -505,7 +586,8 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setValueStepSize(double v){
-        getNode().set_value_step_size( v );
+        editNode().set_value_step_size( v );
+        stepSize = v;
         return *this;
     }
     /**
@@ -513,7 +595,8 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& unsetValueStepSize(){
-        getNode().unset_value_step_size();
+        editNode().unset_value_step_size();
+        stepSize = 0;
         return *this;
     }
     /**
@@ -522,14 +605,47 @@ class ofxOssiaNode {
      */
     double getValueStepSize()
         { return getNode().get_value_step_size();}
+
+    /**With a deadband, changes of this node's ofParameter are only published when they move
+     * its value more than a threshold away from the last value published (on any of its components).
+     * Once the value stops changing for 'settleDelay' milliseconds, its exact latest value
+     * is published anyway (by the server's update()), so that the final value is never lost.
+     * This is not an OSCQuery attribute: it only filters what this application publishes.
+     * @brief sets a deadband on the changes published by this node
+     * @param epsilon the threshold, or 0 to use this node's value_step_size
+     * @param settleDelay the delay, in milliseconds, after which the latest value is published anyway
+     * @return a reference to this node
+     */
+    ofxOssiaNode& setDeadband(double epsilon = 0, int settleDelay = 100){
+        deadband = true;
+        deadbandEpsilon = epsilon;
+        settleTime = std::chrono::milliseconds(std::max(settleDelay, 0));
+        return *this;
+    }
+    /**
+     * @brief removes the deadband of this node: every change is published
+     * @return a reference to this node
+     */
+    ofxOssiaNode& unsetDeadband(){
+        deadband = false;
+        return *this;
+    }
+    /**
+     * @brief gets the threshold of this node's deadband
+     * @return the threshold in use (0 if there is no deadband)
+     */
+    double getDeadband()
+        { return deadband ? getDeadbandThreshold() : 0;}
     
     /**Nodes with the highest priority should execute first.
+     * The server also publishes them first, when its output budget doesn't allow to flush all changes at once.
      * @brief sets the priority attribute of this node's parameter
      * @param v a float with this node's parameter's priority value (higher numbers for higher priorities)
      * @return a reference to this node
      */
     ofxOssiaNode& setPriority(float v){
-        getNode().set_priority( v );
+        editNode().set_priority( v );
+        priority = v;
         return *this;
     }
     /**
@@ -537,7 +653,8 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& unsetPriority(){
-        getNode().unset_priority();
+        editNode().unset_priority();
+        priority = 0;
         return *this;
     }
     /**
@@ -553,7 +670,7 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setDisabled(bool v){
-        getNode().set_disabled( v );
+        editNode().set_disabled( v );
         return *this;
     }
     /**
@@ -570,7 +687,7 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setMuted(bool v){
-        getNode().set_muted( v );
+        editNode().set_muted( v );
         return *this;
     }
     /**
@@ -582,20 +699,21 @@ class ofxOssiaNode {
     
 
     /**For nodes that can have instantiatable children, this sets the minimum and maximum number of children that can exist.
-     * This is an optional attribute: it is not enforced and is only to be relied upon as a metadata.
+     * This is an optional attribute: it is not enforced and is only to be relied upon as a metadata
+     * (except for the instances of ofxOscQueryServer::addInstances(), whose bounds are enforced).
      * @brief sets how many instances this node can have
      * @param min the minimum number of instances this node can have
      * @param max the maximum number of instances this node can have
      * @return a reference to this node
      */
     ofxOssiaNode& setInstanceBounds(int min, int max)
-        {getNode().set_instance_bounds(min, max); return *this;}
+        {editNode().set_instance_bounds(min, max); return *this;}
     /**
      * @brief unset how many instances this node can have
      * @return a reference to this node
      */
     ofxOssiaNode& unsetInstanceBounds()
-        {getNode().unset_instance_bounds(); return *this;}
+        {editNode().unset_instance_bounds(); return *this;}
     /**
      * @brief gets how many instances this node can have
      * @return a std::pair with the minimum and maxium number sof instances this node can have
@@ -609,7 +727,7 @@ class ofxOssiaNode {
      * @return a reference to this node
      */
     ofxOssiaNode& setHidden(bool v)
-        {getNode().set_hidden(v); return *this;}
+        {editNode().set_hidden(v); return *this;}
     /**
      * @brief gets this node's hidden attribute
      * @return a bool: true if the node is hidden
@@ -641,23 +759,29 @@ class ofxOssiaNode {
     ofxOssiaNode() = default;
 
     /*
-   *Constructor for the Root Node
+   *Constructor for the Root Node: the root of the device, or the node of the server in a shared engine
    */
 
-    ofxOssiaNode(opp::oscquery_server& dev, ofParameterGroup& group):
-      currentNode{dev.get_root_node()},
+    ofxOssiaNode(opp::node root, ofParameterGroup& group,
+                 ofxOssiaTreeContext& context, std::uint32_t handle):
+      currentNode{root},
       ofParam{&group},
-      path{"/"}
+      tree{&context},
+      path{context.paths.root()},
+      handle{handle}
     {}
 
     /*
    *Constructor for ParameterGroup Nodes
    */
 
-    ofxOssiaNode(ofxOssiaNode& parentNode, ofParameterGroup& group):
+    ofxOssiaNode(ofxOssiaNode& parentNode, ofParameterGroup& group, std::uint32_t handle):
       currentNode{parentNode.getNode().create_child(group.getName())},
       ofParam{&group},
-      path{parentNode.getPath()+currentNode.get_name()+"/"}
+      tree{parentNode.tree},
+      path{tree->paths.add(parentNode.path, currentNode.get_name())},
+      handle{handle},
+      parent{parentNode.handle}
     {
       ofParam->setName(currentNode.get_name());
     }
@@ -666,10 +790,15 @@ class ofxOssiaNode {
    *Constructor for all Parameter Nodes
    * */
     template<typename DataValue>
-    ofxOssiaNode(ofxOssiaNode& parentNode, ofParameter<DataValue>& param):
+    ofxOssiaNode(ofxOssiaNode& parentNode, ofParameter<DataValue>& param, std::uint32_t handle):
       currentNode{ossia::MatchingType<DataValue>::create_parameter(param.getName(), parentNode.getNode())},
       ofParam{&param},
-      path{parentNode.getPath()+currentNode.get_name()+"/"}
+      tree{parentNode.tree},
+      path{tree->paths.add(parentNode.path, currentNode.get_name())},
+      handle{handle},
+      parent{parentNode.handle},
+      slot{new ofxOssiaValueSlot<DataValue>(param, this)},
+      ops{getTypeOps<DataValue>()}
     {
       using ossia_type = ossia::MatchingType<DataValue>;
 
@@ -684,25 +813,68 @@ class ofxOssiaNode {
       currentNode.set_min(ossia_type::convert(param.getMin())); // TODO: fix this in ossia-cpp
       currentNode.set_max(ossia_type::convert(param.getMax())); // TODO: fix this in ossia-cpp
 
+      //registers to the queue used for deferred updates
+      tree->inbound.add(handle, slot.get());
+
       //adds callback from ossia Node to ofParameter
       callbackIt = currentNode.set_value_callback([](void* context, const opp::value& val)
       {
-        ofParameter<DataValue>* self = reinterpret_cast<ofParameter<DataValue>*>(context);
+        ofxOssiaNode* self = reinterpret_cast<ofxOssiaNode*>(context);
+
+        // this is our own value, being published
+        if(ofxOssiaLocalUpdate::current() == self) return;
+        // a destroyed instance, waiting in the pool
+        if(self->pooled.load(std::memory_order_acquire)) return;
+
+        if(self->lazyGroup.load(std::memory_order_relaxed)) self->touch();
+
+        auto& metrics = self->tree->metrics;
+        bool measured = metrics.isEnabled();
+        ofxOssiaTimer timer(metrics.callbackTime, measured && metrics.sample());
+        if(measured) self->count(&ofxOssiaNodeMetrics::received);
           
         if(ossia_type::is_valid(val))
         {
           DataValue data = ossia_type::convertFromOssia(val);
-          if(data != self->get())
+          if(self->tree->recorder.isRecording())
+            self->tree->recorder.record(ofxOssiaRecorder::Received, self->handle, data);
+          auto& slot = self->getSlot<DataValue>();
+          if(self->staged.load(std::memory_order_relaxed))
+          {
+            // within a transaction: applied with the other values once it's committed
+            // (counted as staging, so that the transaction can't be freed meanwhile)
+            self->tree->staging.fetch_add(1);
+            ofxOssiaStagedUpdates* staged = self->staged.load();
+            if(staged)
+            {
+              slot.store(std::move(data));
+              staged->stage(self->handle, slot);
+            }
+            self->tree->staging.fetch_sub(1);
+            if(staged) return;
+          }
+          if(self->tree->inbound.isDeferred())
+          {
+            // only keep the latest value, it will be applied from the main thread
+            slot.store(std::move(data));
+            self->tree->inbound.enqueue(self->handle, slot);
+            return;
+          }
+          slot.setPublished(data);
+          ofParameter<DataValue>* param = static_cast<ofParameter<DataValue>*>(self->ofParam);
+          if(data != param->get())
           {
-            self->set(data);
+            ofxOssiaRemoteUpdate remote(self);
+            param->set(data);
           }
         }
         else
         {
+          if(measured) self->count(&ofxOssiaNodeMetrics::mismatches);
           std::cerr << "error [ofxOscQuery::enableRemoteUpdate()] : of and ossia types do not match \n" ;
           return;
         }
-      },  ofParam);
+      },  this);
         
       //adds callback from ofParameter to ossia Node
       param.addListener(this, &ofxOssiaNode::listen<DataValue>);
@@ -713,8 +885,32 @@ class ofxOssiaNode {
     template<typename DataValue>
     void listen(DataValue &data)
     {
+        if(ofxOssiaRemoteUpdate::current() != this)
+        {
+            if(tree->recorder.isRecording()) tree->recorder.record(ofxOssiaRecorder::Sent, handle, data);
+
+            // changes within the deadband are only published once settled
+            if(deadband && getSlot<DataValue>().distanceToPublished(data) <= getDeadbandThreshold())
+            {
+                settling = true;
+                lastChange = std::chrono::steady_clock::now();
+                tree->outbound.mark(handle);
+                return;
+            }
+
+            // when coalescing, or when the refresh rate doesn't allow to publish yet,
+            // changes made by the application are published by the next (due) flush
+            // (values set from the network thread are handled right away, as they already are published)
+            if(tree->outbound.isCoalescing() || !isDue())
+            {
+                tree->outbound.mark(handle);
+                return;
+            }
+        }
+
         // check if the value to be published is not already published
-        if(pullNodeValue<DataValue>() != data)
+        // (which is the case for values received from the network)
+        if(!getSlot<DataValue>().isPublished(data))
         { // i-score->GUI OK
             publishValue(data);
         }
@@ -722,57 +918,93 @@ class ofxOssiaNode {
 
     /*
    * Copy operations
+   * Nodes register themselves to ossia callbacks and ofParameter listeners,
+   * so they can neither be copied nor moved
    * */
-    ofxOssiaNode(const ofxOssiaNode&) = default;
-    ofxOssiaNode(ofxOssiaNode&&) = default;
-    ofxOssiaNode& operator=(const ofxOssiaNode&) = default;
-    ofxOssiaNode& operator=(ofxOssiaNode&&) = default;
+    ofxOssiaNode(const ofxOssiaNode&) = delete;
+    ofxOssiaNode(ofxOssiaNode&&) = delete;
+    ofxOssiaNode& operator=(const ofxOssiaNode&) = delete;
+    ofxOssiaNode& operator=(ofxOssiaNode&&) = delete;
 
     /*
     * Destructor
     * */
     ~ofxOssiaNode () {
         if (callbackIt) currentNode.remove_value_callback(callbackIt);
-        
-        auto type = ofParam->type();
-        if(type == typeid(ofParameter <int32_t>).name())
-            static_cast<ofParameter<int32_t>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<int32_t>);
-        else if(type == typeid(ofParameter <int>).name())
-            static_cast<ofParameter<int>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<int>);
-        else if(type == typeid(ofParameter <float>).name())
-            static_cast<ofParameter<float>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<float>);
-        else if(type == typeid(ofParameter <double>).name())
-            static_cast<ofParameter<double>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<double>);
-        else if(type == typeid(ofParameter <bool>).name())
-            static_cast<ofParameter<bool>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<bool>);
-        else if(type == typeid(ofParameter <glm::vec2>).name())
-            static_cast<ofParameter<glm::vec2>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<glm::vec2>);
-        else if(type == typeid(ofParameter <glm::vec3>).name())
-            static_cast<ofParameter<glm::vec3>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<glm::vec3>);
-        else if(type == typeid(ofParameter <glm::vec4>).name())
-            static_cast<ofParameter<glm::vec4>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<glm::vec4>);
-        else if(type == typeid(ofParameter <ofVec2f>).name())
-            static_cast<ofParameter<ofVec2f>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<ofVec2f>);
-        else if(type == typeid(ofParameter <ofVec3f>).name())
-            static_cast<ofParameter<ofVec3f>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<ofVec3f>);
-        else if(type == typeid(ofParameter <ofVec4f>).name())
-            static_cast<ofParameter<ofVec4f>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<ofVec4f>);
-        else if(type == typeid(ofParameter <ofColor>).name())
-            static_cast<ofParameter<ofColor>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<ofColor>);
-        else if(type == typeid(ofParameter <ofFloatColor>).name())
-            static_cast<ofParameter<ofFloatColor>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<ofFloatColor>);
-        else if(type == typeid(ofParameter <std::string>).name())
-            static_cast<ofParameter<std::string>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<std::string>);
+        if (slot) tree->inbound.remove(handle);
+        if (ops) (this->*ops->teardown)();
     }
     
 
   private:
 
+    static constexpr std::uint32_t none = std::uint32_t(-1);
+
     opp::node currentNode;
     ofAbstractParameter* ofParam = nullptr;
-    std::string path;
+    // the group's reference to ofParam, which it keeps alive (none for the root)
+    std::shared_ptr<ofAbstractParameter> paramRef;
+    ofxOssiaTreeContext* tree = nullptr;
+    ofxOssiaPathPool::Path path;
+    // position in the server's tree, as handles of its nodes
+    std::uint32_t handle = none;
+    std::uint32_t generation = 0;
+    std::uint32_t parent = none;
+    std::uint32_t firstChild = none;
+    std::uint32_t lastChild = none;
+    std::uint32_t nextSibling = none;
     opp::callback_index callbackIt;
+    std::unique_ptr<ofxOssiaAbstractSlot> slot;
+    ofxOssiaNodeMetrics metrics;
+    // the node of the lazy group this node belongs to, if any
+    // (set from the main thread, read by the value callback)
+    std::atomic<ofxOssiaNode*> lazyGroup{nullptr};
+    // for the nodes of lazy groups: time of the last use of the group, in ticks of the steady clock
+    std::atomic<std::uint64_t> lastUse{0};
+    // an attribute has been set (see editNode()), to be kept while its lazy group is collapsed
+    bool edited = false;
+    // within a destroyed instance kept for reuse: the values received are ignored
+    std::atomic<bool> pooled{false};
+    // the transaction holding the values received, if this node is within a transactional group
+    std::atomic<ofxOssiaStagedUpdates*> staged{nullptr};
+    // outbound scheduling, from the refresh_rate and priority attributes
+    std::chrono::steady_clock::duration refreshInterval{0};
+    std::chrono::steady_clock::time_point lastSent;
+    float priority = 0;
+    // deadband, with the step size it can be based on
+    double stepSize = 0;
+    double deadbandEpsilon = 0;
+    bool deadband = false;
+    // a change within the deadband is waiting to be published
+    bool settling = false;
+    std::chrono::steady_clock::duration settleTime{0};
+    std::chrono::steady_clock::time_point lastChange;
+
+    // Operations depending on the type of the ofParameter, shared by all nodes of that type
+    struct TypeOps {
+      // publishes the current value of the ofParameter, if not already published
+      void (ofxOssiaNode::*publish)();
+      // removes the listener of the ofParameter
+      void (ofxOssiaNode::*teardown)();
+      // adds the current value of the ofParameter to a snapshot
+      void (ofxOssiaNode::*capture)(ofxOssiaSnapshot&);
+      // sets the ofParameter to the i-th value of a snapshot's column
+      // returns false if the column's type doesn't match, or if the value is unchanged
+      bool (ofxOssiaNode::*recall)(const ofxOssiaSnapshot::AbstractColumn&, std::size_t);
+      // sets the value of a record, as received from the network, or as set by the application
+      // returns false if it can't be decoded
+      bool (ofxOssiaNode::*replay)(const char*, std::size_t, bool received);
+      // sets the domain (either bound being optional), as in setRangeMin() / setRangeMax()
+      // returns false if a bound isn't of the parameter's type, and thus not set
+      bool (ofxOssiaNode::*setRange)(const opp::value* min, const opp::value* max);
+      const std::type_info* valueType;
+      // as written in recordings (see ossia::typeName())
+      const std::string* typeName;
+    };
+    // nullptr for the root and group nodes
+    const TypeOps* ops = nullptr;
     friend class ofxOscQueryServer;
+    friend class ofxOssiaReplayer;
 
 
 
@@ -781,40 +1013,130 @@ class ofxOssiaNode {
     //////////////////////////////////////////////
 
     opp::node& getNode()       {return currentNode;}
+    // For the attribute setters: the namespace has changed (see ofxOscQueryServer::setNamespaceListener())
+    opp::node& editNode()      {tree->namespaceChanged = true; edited = true; return currentNode;}
 
     template<typename DataValue>
-    void publishValue(DataValue val){
+    ofxOssiaValueSlot<DataValue>& getSlot(){
+      return static_cast<ofxOssiaValueSlot<DataValue>&>(*slot);
+    }
+
+    // Increments one of this node's counters, and the server's total
+    void count(std::atomic<std::uint64_t> ofxOssiaNodeMetrics::* counter){
+      (metrics.*counter).fetch_add(1, std::memory_order_relaxed);
+      (tree->metrics.totals.*counter).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Marks the lazy group this node belongs to as used, and those holding it:
+    // a group node outlives the nodes within it, so the chain can be walked from any thread
+    void touch(){
+      std::uint64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+      lastUse.store(now, std::memory_order_relaxed);
+      for(ofxOssiaNode* group = lazyGroup.load(std::memory_order_relaxed); group; group = group->lazyGroup.load(std::memory_order_relaxed))
+        group->lastUse.store(now, std::memory_order_relaxed);
+    }
+
+    // Whether the refresh rate allows to publish a new value
+    bool isDue() const {
+      return refreshInterval.count() == 0
+          || std::chrono::steady_clock::now() - lastSent >= refreshInterval;
+    }
+
+    double getDeadbandThreshold() const {
+      return deadbandEpsilon > 0 ? deadbandEpsilon : stepSize;
+    }
+
+    // Whether a change within the deadband has been stable long enough to be published
+    bool isSettled() const {
+      return !settling || std::chrono::steady_clock::now() - lastChange >= settleTime;
+    }
+
+    template<typename DataValue>
+    void publishValue(const DataValue& val){
       using ossia_type = ossia::MatchingType<DataValue>;
+      bool measured = tree->metrics.isEnabled();
+      ofxOssiaTimer timer(tree->metrics.publishTime, measured && tree->metrics.sample());
+      if(measured) count(&ofxOssiaNodeMetrics::sent);
+      if(refreshInterval.count()) lastSent = std::chrono::steady_clock::now();
+      settling = false;
+      getSlot<DataValue>().setPublished(val);
+      ofxOssiaLocalUpdate local(this);
       currentNode.set_value(ossia_type::convert(val));
     }
 
     template<typename DataValue>
-    DataValue pullNodeValue()
-    {
+    void removeParamListener(){
+      static_cast<ofParameter<DataValue>*>(ofParam)->removeListener(this, &ofxOssiaNode::listen<DataValue>);
+    }
+
+    template<typename DataValue>
+    static const TypeOps* getTypeOps(){
+      static const TypeOps typeOps{
+        &ofxOssiaNode::publishParamValue<DataValue>,
+        &ofxOssiaNode::removeParamListener<DataValue>,
+        &ofxOssiaNode::captureParamValue<DataValue>,
+        &ofxOssiaNode::recallParamValue<DataValue>,
+        &ofxOssiaNode::replayParamValue<DataValue>,
+        &ofxOssiaNode::setParamRange<DataValue>,
+        &typeid(DataValue),
+        &ossia::typeName<DataValue>()
+      };
+      return &typeOps;
+    }
+
+    template<typename DataValue>
+    void captureParamValue(ofxOssiaSnapshot& snapshot){
+      snapshot.column<DataValue>().add(handle, generation, static_cast<ofParameter<DataValue>*>(ofParam)->get());
+    }
+
+    template<typename DataValue>
+    bool recallParamValue(const ofxOssiaSnapshot::AbstractColumn& column, std::size_t i){
+      if(column.typeId() != ofxOssiaTypeId<DataValue>()) return false;
+      const DataValue& value = static_cast<const ofxOssiaSnapshot::Column<DataValue>&>(column).values[i];
+      ofParameter<DataValue>* param = static_cast<ofParameter<DataValue>*>(ofParam);
+      if(value == param->get()) return false;
+      param->set(value);
+      return true;
+    }
+
+    template<typename DataValue>
+    bool replayParamValue(const char* data, std::size_t size, bool received){
+      DataValue value;
+      if(!ofxOssiaRecordCodec<DataValue>::read(data, size, value)) return false;
+      // through the value callback, just like a value received from the network
+      if(received) currentNode.set_value(ossia::MatchingType<DataValue>::convert(value));
+      else static_cast<ofParameter<DataValue>*>(ofParam)->set(value);
+      return true;
+    }
+
+    template<typename DataValue>
+    bool setParamRange(const opp::value* min, const opp::value* max){
       using ossia_type = ossia::MatchingType<DataValue>;
+      ofParameter<DataValue>* param = static_cast<ofParameter<DataValue>*>(ofParam);
+      opp::value low, high;
+      bool validMin = !min || rangeValue<DataValue>(*min, low);
+      bool validMax = !max || rangeValue<DataValue>(*max, high);
+      if(min && validMin){ editNode().set_min(low); param->setMin(ossia_type::convertFromOssia(low)); }
+      if(max && validMax){ editNode().set_max(high); param->setMax(ossia_type::convertFromOssia(high)); }
+      return validMin && validMax;
+    }
 
-      try
-      {
-        auto val = currentNode.get_value();
-          if(ossia_type::is_valid(val)){
-              return ossia_type::convertFromOssia(val);
-          }
-        else
-          std::cerr <<  "error [ofxOssia::pullNodeValue()] : of and ossia types do not match \n" ;
-        return {};
-      }
-      catch(std::exception& e)
-      {
-        std::cerr <<  "error [ofxOssia::pullNodeValue()] : " << e.what() << "\n" ;
-        return {};
-      }
+    // A bound of the parameter's type, numbers read from files being ints for floats and conversely
+    template<typename DataValue>
+    static bool rangeValue(const opp::value& v, opp::value& result){
+      using ossia_type = ossia::MatchingType<DataValue>;
+      if(ossia_type::is_valid(v)) result = v;
+      else if(v.is_int() && ossia_type::is_valid(opp::value(float(v.to_int())))) result = opp::value(float(v.to_int()));
+      else if(v.is_float() && ossia_type::is_valid(opp::value(int(v.to_float())))) result = opp::value(int(v.to_float()));
+      else return false;
+      return true;
+    }
 
-      catch(...)
-      {
-        auto val = currentNode.get_value();
-        std::cerr <<  "error [ofxOssia::pullNodeValue()] : : of and ossia types do not match \n" ;
-        return {};
-      }
+    template<typename DataValue>
+    void publishParamValue(){
+      settling = false;
+      const DataValue& data = static_cast<ofParameter<DataValue>*>(ofParam)->get();
+      if(!getSlot<DataValue>().isPublished(data)) publishValue(data);
     }
 
 };
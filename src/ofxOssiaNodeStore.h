@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Storage for the nodes of a server:
+ * nodes are allocated by blocks, and identified by an integer handle,
+ * which stays valid (as does the node's address) until the node is erased.
+ * Erased handles are recycled by the next nodes created: each time a handle is erased
+ * its generation is incremented, so that a handle and its generation identify a node for good
+ * */
+
+template<typename Node, std::size_t BlockSize = 256>
+class ofxOssiaNodeStore {
+
+  public:
+
+    static constexpr std::uint32_t invalid = std::uint32_t(-1);
+
+    ofxOssiaNodeStore() = default;
+    ofxOssiaNodeStore(const ofxOssiaNodeStore&) = delete;
+    ofxOssiaNodeStore& operator=(const ofxOssiaNodeStore&) = delete;
+    ~ofxOssiaNodeStore() { clear(); }
+
+    /**
+     * @brief constructs a node, its handle being passed as the last argument of its constructor
+     * @return a reference to the new node
+     */
+    template<typename... Args>
+    Node& emplace(Args&&... args)
+    {
+      std::uint32_t handle;
+      if (!freeHandles.empty())
+      {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+      }
+      else
+      {
+        handle = std::uint32_t(alive.size());
+        if (handle % BlockSize == 0) blocks.emplace_back(new Block);
+        alive.push_back(false);
+        if (handle >= generations.size()) generations.push_back(0);
+      }
+
+      Node* node;
+      try { node = new (address(handle)) Node(std::forward<Args>(args)..., handle); }
+      catch (...) { freeHandles.push_back(handle); throw; }
+
+      alive[handle] = true;
+      ++count;
+      return *node;
+    }
+
+    void erase(std::uint32_t handle)
+    {
+      if (!contains(handle)) return;
+      address(handle)->~Node();
+      alive[handle] = false;
+      ++generations[handle];
+      freeHandles.push_back(handle);
+      --count;
+    }
+
+    void clear()
+    {
+      for (std::size_t handle = alive.size(); handle-- > 0;)
+        if (alive[handle]) { address(std::uint32_t(handle))->~Node(); ++generations[handle]; }
+      alive.clear();
+      freeHandles.clear();
+      blocks.clear();
+      count = 0;
+    }
+
+    bool contains(std::uint32_t handle) const
+      { return handle < alive.size() && alive[handle]; }
+
+    // nullptr if there is no node with this handle
+    Node* get(std::uint32_t handle)
+      { return contains(handle) ? address(handle) : nullptr; }
+
+    // nullptr as well if the handle has been recycled since that generation
+    Node* get(std::uint32_t handle, std::uint32_t generation)
+      { return contains(handle) && generations[handle] == generation ? address(handle) : nullptr; }
+
+    std::uint32_t generation(std::uint32_t handle) const
+      { return handle < generations.size() ? generations[handle] : 0; }
+
+    Node& operator[](std::uint32_t handle)
+      { return *address(handle); }
+
+    std::size_t size() const  { return count; }
+    bool empty() const        { return count == 0; }
+    // upper bound of all handles in use
+    std::uint32_t capacity() const { return std::uint32_t(alive.size()); }
+
+    /*
+     * Iteration over all nodes, by increasing handle
+     */
+    class iterator {
+      public:
+        iterator(ofxOssiaNodeStore& store, std::uint32_t handle): store(store), handle(handle) { skip(); }
+        Node& operator*()  const { return store[handle]; }
+        Node* operator->() const { return &store[handle]; }
+        iterator& operator++() { ++handle; skip(); return *this; }
+        bool operator==(const iterator& other) const { return handle == other.handle; }
+        bool operator!=(const iterator& other) const { return handle != other.handle; }
+      private:
+        void skip() { while (handle < store.capacity() && !store.alive[handle]) ++handle; }
+        ofxOssiaNodeStore& store;
+        std::uint32_t handle;
+    };
+
+    iterator begin() { return iterator(*this, 0); }
+    iterator end()   { return iterator(*this, capacity()); }
+
+  private:
+
+    struct Block {
+      typename std::aligned_storage<sizeof(Node), alignof(Node)>::type items[BlockSize];
+    };
+
+    Node* address(std::uint32_t handle)
+      { return reinterpret_cast<Node*>(&blocks[handle / BlockSize]->items[handle % BlockSize]); }
+
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::vector<bool> alive;
+    // kept when cleared, as handles are then reused
+    std::vector<std::uint32_t> generations;
+    std::vector<std::uint32_t> freeHandles;
+    std::size_t count = 0;
+};
+
+template<typename Node, std::size_t BlockSize>
+constexpr std::uint32_t ofxOssiaNodeStore<Node, BlockSize>::invalid;
+
+
+/*
+ * All the paths of a server's nodes, stored as a tree of names:
+ * each path only holds its node's own name (in a shared buffer) and its parent's path,
+ * full paths being rebuilt on demand, so that memory grows with the number of nodes, not with their depth.
+ * The names of removed nodes are left in place, until most of the pool is
+ * made of them: the server then rewrites the paths of its nodes into a new pool
+ * */
+
+class ofxOssiaPathPool {
+
+  public:
+
+    struct Path {
+      std::uint32_t index = 0;
+    };
+
+    // The root's path, "/"
+    Path root()
+    {
+      if (entries.empty()) entries.push_back(Entry{0, 0, 0, 1});
+      return Path{0};
+    }
+
+    // Adds a child's path: the parent's path + name + "/"
+    Path add(Path parent, const std::string& name) { return add(parent, name.data(), name.size()); }
+    Path add(Path parent, const char* name, std::size_t length)
+    {
+      // positions are 32-bit
+      if (names.size() + length > std::numeric_limits<std::uint32_t>::max()
+          || entries.size() >= std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("ofxOssiaPathPool: paths exceed 4 GB");
+      Entry entry{parent.index, std::uint32_t(names.size()), std::uint32_t(length),
+                  std::uint32_t(entries[parent.index].length + length + 1)};
+      names.append(name, length);
+      entries.push_back(entry);
+      return Path{std::uint32_t(entries.size() - 1)};
+    }
+
+    // The path of a removed node, to be reclaimed
+    void release(Path path) { garbage += entries[path.index].nameLength + sizeof(Entry); }
+
+    // Whether most of the pool is made of released paths
+    bool isFragmented() const { return size() > 4096 && garbage > size() / 2; }
+
+    // The node's own name (not null-terminated), only valid until the next path is added
+    const char* name(Path path) const { return names.data() + entries[path.index].offset; }
+    std::size_t nameLength(Path path) const { return entries[path.index].nameLength; }
+
+    // The length of the full path "/parent/name/"
+    std::size_t length(Path path) const { return entries[path.index].length; }
+
+    // Rebuilds the full path "/parent/name/" into 'out' (reusing its capacity), from the end
+    void get(Path path, std::string& out) const
+    {
+      const Entry* entry = &entries[path.index];
+      out.assign(entry->length, '/');
+      std::size_t end = entry->length - 1;
+      while (path.index != 0){
+        end -= entry->nameLength;
+        std::memcpy(&out[end], names.data() + entry->offset, entry->nameLength);
+        --end;
+        path.index = entry->parent;
+        entry = &entries[path.index];
+      }
+    }
+
+    std::string get(Path path) const
+    {
+      std::string out;
+      get(path, out);
+      return out;
+    }
+
+    // Whether a path, without its leading and trailing '/' ("parent/name"), is this one:
+    // compared name by name from the end, without rebuilding it
+    bool equals(Path path, const char* other, std::size_t length) const
+    {
+      std::size_t full = entries[path.index].length;
+      if (length != (full > 1 ? full - 2 : 0)) return false;
+      std::size_t end = length;
+      while (path.index != 0){
+        const Entry& entry = entries[path.index];
+        end -= entry.nameLength;
+        if (std::memcmp(other + end, names.data() + entry.offset, entry.nameLength) != 0) return false;
+        if (entry.parent != 0 && other[--end] != '/') return false;
+        path.index = entry.parent;
+      }
+      return true;
+    }
+
+    // In bytes, released paths included
+    std::size_t size() const { return names.size() + entries.size() * sizeof(Entry); }
+
+  private:
+
+    struct Entry {
+      std::uint32_t parent;
+      std::uint32_t offset;
+      std::uint32_t nameLength;
+      // of the full path, with its leading and trailing '/'
+      std::uint32_t length;
+    };
+
+    std::vector<Entry> entries;
+    std::string names;
+    std::size_t garbage = 0;
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Pattern matching the paths of the nodes of a server, with the syntax of OSC address patterns:
+// '?' matches any character but '/', '*' any sequence of them, '[abc]', '[a-z]' and '[!abc]'
+// a character of (or not of) a set, '{foo,bar}' either string; and '**' any sequence of characters,
+// '/' included ("/renderer/**" matches all the nodes below /renderer, "/**" + "/color" all the colors).
+// Paths and patterns are relative to the server, with a leading '/' and without a trailing one.
+// Patterns are also split into segments, matched one level of the tree at a time (see ofxOscQueryServer::select())
+
+class ofxOssiaPathPattern {
+
+  public:
+
+    ofxOssiaPathPattern() = default;
+    explicit ofxOssiaPathPattern(const std::string& p): pattern(normalize(p))
+    {
+      prefixLength = pattern.find_first_of("?*[{");
+      literal = prefixLength == std::string::npos;
+      if (literal) prefixLength = pattern.size();
+      split();
+    }
+
+    const std::string& str() const { return pattern; }
+    // Without any wildcard: matches its own path only
+    bool isLiteral() const { return literal; }
+
+    bool matches(const std::string& path) const { return matches(path.data(), path.size()); }
+    bool matches(const char* path, std::size_t length) const
+    {
+      // most paths are rejected by the characters before the first wildcard
+      if (length < prefixLength || std::memcmp(path, pattern.data(), prefixLength) != 0) return false;
+      if (literal) return length == prefixLength;
+      return match(pattern.data() + prefixLength, pattern.data() + pattern.size(), path + prefixLength, path + length);
+    }
+
+    /*
+     * The names between the '/' of a pattern, after the literal ones
+     * at its start (see getDirectory()):
+     * literal names, patterns of a single name, and the rest of the pattern once it
+     * may match several levels ('**', or a '/' within brackets), to be matched against whole paths
+     */
+    struct Segment {
+      enum Kind { Literal, Name, Rest };
+      Kind kind;
+      std::size_t begin, end;
+    };
+    const std::vector<Segment>& getSegments() const { return segments; }
+    // The literal path the segments start from ("/" for the root)
+    std::string getDirectory() const { return pattern.substr(0, std::max<std::size_t>(directoryLength, 1)); }
+
+    // Whether the pattern may match some paths below 'path' (an upper bound, from its literal start)
+    bool mayMatchBelow(const char* path, std::size_t length) const
+    {
+      if (length <= 1) return true; // the root
+      std::size_t common = std::min(length, prefixLength);
+      if (std::memcmp(path, pattern.data(), common) != 0) return false;
+      return prefixLength > length ? pattern[length] == '/' : true;
+    }
+
+    bool matchesSegment(const Segment& segment, const char* name, std::size_t length) const
+    {
+      if (segment.kind == Segment::Literal)
+        return length == segment.end - segment.begin && std::memcmp(name, pattern.data() + segment.begin, length) == 0;
+      return match(pattern.data() + segment.begin, pattern.data() + segment.end, name, name + length);
+    }
+
+    // A path with a leading '/' and without a trailing one ("/" for the root)
+    static std::string normalize(const std::string& path)
+    {
+      std::string normalized = path.empty() || path[0] != '/' ? "/" + path : path;
+      while (normalized.size() > 1 && normalized.back() == '/') normalized.pop_back();
+      return normalized;
+    }
+
+  private:
+
+    void split()
+    {
+      segments.clear();
+      if (literal) { directoryLength = pattern.size(); return; }
+      directoryLength = pattern.rfind('/', prefixLength);
+      for (std::size_t begin = directoryLength + 1; begin <= pattern.size(); )
+      {
+        std::size_t end = begin;
+        bool wildcard = false, rest = false;
+        int depth = 0;
+        for (; end < pattern.size() && (pattern[end] != '/' || depth > 0); ++end)
+        {
+          char c = pattern[end];
+          if (c == '[' || c == '{') ++depth;
+          else if ((c == ']' || c == '}') && depth > 0) --depth;
+          else if (c == '/') rest = true;
+          if (c == '*' && end + 1 < pattern.size() && pattern[end + 1] == '*') rest = true;
+          wildcard = wildcard || c == '?' || c == '*' || c == '[' || c == '{';
+        }
+        if (rest) { segments.push_back({Segment::Rest, begin, pattern.size()}); return; }
+        segments.push_back({wildcard ? Segment::Name : Segment::Literal, begin, end});
+        begin = end + 1;
+      }
+    }
+
+    static bool match(const char* p, const char* pe, const char* s, const char* se)
+    {
+      while (p < pe)
+      {
+        switch (*p)
+        {
+          case '*':
+          {
+            bool any = p + 1 < pe && p[1] == '*';
+            p += any ? 2 : 1;
+            // "a/**/b" also matches "a/b"
+            if (any && p < pe && *p == '/' && match(p + 1, pe, s, se)) return true;
+            for (const char* t = s; ; ++t)
+            {
+              if (match(p, pe, t, se)) return true;
+              if (t == se || (!any && *t == '/')) return false;
+            }
+          }
+          case '?':
+            if (s == se || *s == '/') return false;
+            ++p; ++s;
+            break;
+          case '[':
+          {
+            if (s == se || *s == '/') return false;
+            const char* end = static_cast<const char*>(std::memchr(p, ']', pe - p));
+            if (!end) return false;
+            bool negated = p[1] == '!';
+            bool found = false;
+            for (const char* c = p + (negated ? 2 : 1); c < end; ++c)
+            {
+              if (c + 2 < end && c[1] == '-'){ found = found || (*s >= c[0] && *s <= c[2]); c += 2; }
+              else found = found || *s == *c;
+            }
+            if (found == negated) return false;
+            p = end + 1; ++s;
+            break;
+          }
+          case '{':
+          {
+            const char* end = static_cast<const char*>(std::memchr(p, '}', pe - p));
+            if (!end) return false;
+            for (const char* alternative = p + 1; alternative <= end; )
+            {
+              const char* next = alternative;
+              while (next < end && *next != ',') ++next;
+              std::size_t length = next - alternative;
+              if (std::size_t(se - s) >= length && std::memcmp(s, alternative, length) == 0
+                  && match(end + 1, pe, s + length, se)) return true;
+              alternative = next + 1;
+            }
+            return false;
+          }
+          default:
+            if (s == se || *s != *p) return false;
+            ++p; ++s;
+        }
+      }
+      return s == se;
+    }
+
+    std::string pattern;
+    std::size_t prefixLength = 0;
+    bool literal = true;
+    std::size_t directoryLength = 0;
+    std::vector<Segment> segments;
+};
@@ -0,0 +1,115 @@
+#include "ofxOssiaRecorder.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+constexpr char ofxOssiaRecorder::magic[4];
+constexpr std::uint32_t ofxOssiaRecorder::version;
+
+bool ofxOssiaRecorder::open(const std::string& file, std::size_t size)
+{
+  close();
+  capacity = std::max(size, sizeof(FileHeader));
+
+#if defined(_WIN32)
+  HANDLE f = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                         CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (f == INVALID_HANDLE_VALUE)
+  {
+    std::cerr << "error [ofxOssiaRecorder::open()] : could not create " << file << std::endl;
+    return false;
+  }
+  LARGE_INTEGER length;
+  length.QuadPart = LONGLONG(capacity);
+  HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READWRITE, length.HighPart, length.LowPart, nullptr);
+  void* view = m ? MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, capacity) : nullptr;
+  if (!view)
+  {
+    std::cerr << "error [ofxOssiaRecorder::open()] : could not map " << file << std::endl;
+    if (m) CloseHandle(m);
+    CloseHandle(f);
+    return false;
+  }
+  this->file = f;
+  mapping = m;
+#else
+  int f = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (f < 0)
+  {
+    std::cerr << "error [ofxOssiaRecorder::open()] : could not create " << file << std::endl;
+    return false;
+  }
+  void* view = ftruncate(f, off_t(capacity)) == 0
+             ? mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0)
+             : MAP_FAILED;
+  if (view == MAP_FAILED)
+  {
+    std::cerr << "error [ofxOssiaRecorder::open()] : could not map " << file << std::endl;
+    ::close(f);
+    return false;
+  }
+  this->file = f;
+#endif
+  data = static_cast<char*>(view);
+  path = file;
+
+  // touches every page now, rather than on the first record written to it
+  for (std::size_t offset = 0; offset < capacity; offset += 4096) data[offset] = 0;
+
+  FileHeader header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.startTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  std::memcpy(data, &header, sizeof(header));
+
+  end = sizeof(FileHeader);
+  recorded = 0;
+  dropped = 0;
+  startTime = Clock::now();
+  recording = true;
+  return true;
+}
+
+void ofxOssiaRecorder::close()
+{
+  if (!data) return;
+
+  recording = false;
+  while (writers.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+  std::size_t size = getSize();
+
+#if defined(_WIN32)
+  FlushViewOfFile(data, size);
+  UnmapViewOfFile(data);
+  CloseHandle(static_cast<HANDLE>(mapping));
+  LARGE_INTEGER length;
+  length.QuadPart = LONGLONG(size);
+  SetFilePointerEx(static_cast<HANDLE>(file), length, nullptr, FILE_BEGIN);
+  SetEndOfFile(static_cast<HANDLE>(file));
+  CloseHandle(static_cast<HANDLE>(file));
+  file = nullptr;
+  mapping = nullptr;
+#else
+  msync(data, size, MS_SYNC);
+  munmap(data, capacity);
+  if (ftruncate(file, off_t(size)) != 0)
+    std::cerr << "error [ofxOssiaRecorder::close()] : could not truncate " << path << std::endl;
+  ::close(file);
+  file = -1;
+#endif
+  data = nullptr;
+}
+
+std::size_t ofxOssiaRecorder::getSize() const
+{
+  return data ? std::min(end.load(std::memory_order_relaxed), capacity) : 0;
+}
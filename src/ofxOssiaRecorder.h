@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Binary encoding of the values of the records:
+ * trivially copyable types as raw bytes, std::string as its characters,
+ * arrays of trivially copyable types as their contiguous elements,
+ * other types can't be recorded
+ * */
+
+template<typename DataValue, typename Enable = void>
+struct ofxOssiaRecordCodec {
+  static constexpr bool recordable = false;
+  static std::size_t size(const DataValue&) { return 0; }
+  static void write(char*, const DataValue&) {}
+  static bool read(const char*, std::size_t, DataValue&) { return false; }
+};
+
+template<typename DataValue>
+struct ofxOssiaRecordCodec<DataValue, typename std::enable_if<std::is_trivially_copyable<DataValue>::value>::type> {
+  static constexpr bool recordable = true;
+  static std::size_t size(const DataValue&) { return sizeof(DataValue); }
+  static void write(char* out, const DataValue& v) { std::memcpy(out, &v, sizeof(DataValue)); }
+  static bool read(const char* in, std::size_t size, DataValue& v)
+  {
+    if (size != sizeof(DataValue)) return false;
+    std::memcpy(&v, in, sizeof(DataValue));
+    return true;
+  }
+};
+
+template<>
+struct ofxOssiaRecordCodec<std::string> {
+  static constexpr bool recordable = true;
+  static std::size_t size(const std::string& v) { return v.size(); }
+  static void write(char* out, const std::string& v) { std::memcpy(out, v.data(), v.size()); }
+  static bool read(const char* in, std::size_t size, std::string& v) { v.assign(in, size); return true; }
+};
+
+template<typename Element>
+struct ofxOssiaRecordCodec<std::vector<Element>, typename std::enable_if<std::is_trivially_copyable<Element>::value
+                                                                         && !std::is_same<Element, bool>::value>::type> {
+  static constexpr bool recordable = true;
+  static std::size_t size(const std::vector<Element>& v) { return v.size() * sizeof(Element); }
+  static void write(char* out, const std::vector<Element>& v)
+    { if (!v.empty()) std::memcpy(out, v.data(), v.size() * sizeof(Element)); }
+  static bool read(const char* in, std::size_t size, std::vector<Element>& v)
+  {
+    if (size % sizeof(Element)) return false;
+    v.resize(size / sizeof(Element));
+    if (size) std::memcpy(&v[0], in, size);
+    return true;
+  }
+};
+
+
+/*
+ * Records the values received and sent by the nodes of a server
+ * to an append-only log file, mapped in memory:
+ * the file is allocated (and its pages touched) when the recording starts,
+ * so that appending a record only reserves its space with an atomic increment
+ * and copies it, from any thread, without locking nor allocating.
+ * Records that don't fit anymore are dropped (and counted).
+ *
+ * File: a header (magic, version, wall-clock time of the start in ms),
+ * then records of 8-byte aligned lengths, a record being complete once its
+ * length is written (the rest of the file is zeroed)
+ * */
+
+class ofxOssiaRecorder {
+
+  public:
+
+    using Clock = std::chrono::steady_clock;
+
+    enum Kind : std::uint8_t {
+      Declare = 0,  // a node, with the name of its type and its path
+      Received = 1, // a value received from the network
+      Sent = 2      // a value set by the application
+    };
+
+    struct FileHeader {
+      char magic[4];
+      std::uint32_t version;
+      std::uint64_t startTime;
+    };
+
+    struct RecordHeader {
+      // of the whole record, padded to 8 bytes
+      std::uint32_t length;
+      std::uint32_t handle;
+      // nanoseconds since the start of the recording
+      std::uint64_t time;
+      // of the payload following this header
+      std::uint32_t size;
+      std::uint8_t kind;
+      std::uint8_t reserved[3];
+    };
+
+    static constexpr char magic[4] = {'O', 'S', 'Q', 'R'};
+    // version 1 named the types as typeid().name() does, depending on the compiler
+    static constexpr std::uint32_t version = 2;
+
+    ofxOssiaRecorder() = default;
+    ~ofxOssiaRecorder() { close(); }
+    ofxOssiaRecorder(const ofxOssiaRecorder&) = delete;
+    ofxOssiaRecorder& operator=(const ofxOssiaRecorder&) = delete;
+
+    /**
+     * @brief creates the log file, of a fixed capacity, and starts recording
+     * @param capacity in bytes
+     * @return false if the file can't be created or mapped
+     */
+    bool open(const std::string& file, std::size_t capacity);
+    // Stops recording, waiting for the records being written, and truncates the file to its records
+    void close();
+
+    bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+    template<typename DataValue>
+    void record(Kind kind, std::uint32_t handle, const DataValue& value)
+    {
+      using codec = ofxOssiaRecordCodec<DataValue>;
+      if (!codec::recordable) return;
+      std::size_t size = codec::size(value);
+      Writer writer(*this, handle, kind, size);
+      if (writer.payload) codec::write(writer.payload, value);
+    }
+
+    // A node, for the records of its handle that follow
+    void declare(std::uint32_t handle, const char* typeName, const std::string& path)
+    {
+      std::size_t typeLength = std::strlen(typeName) + 1;
+      Writer writer(*this, handle, Declare, typeLength + path.size());
+      if (!writer.payload) return;
+      std::memcpy(writer.payload, typeName, typeLength);
+      std::memcpy(writer.payload + typeLength, path.data(), path.size());
+    }
+
+    // Number of records written, and dropped for lack of space
+    std::uint64_t getRecorded() const { return recorded.load(std::memory_order_relaxed); }
+    std::uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    // Number of bytes used in the log
+    std::size_t getSize() const;
+
+  private:
+
+    // Reserves a record, and commits it when destroyed
+    // (payload is nullptr if not recording, or if there is no room left)
+    struct Writer {
+      Writer(ofxOssiaRecorder& recorder, std::uint32_t handle, Kind kind, std::size_t size);
+      ~Writer();
+      ofxOssiaRecorder& recorder;
+      RecordHeader* header = nullptr;
+      char* payload = nullptr;
+    };
+
+    std::atomic<bool> recording{false};
+    // threads within record(), waited for by close()
+    std::atomic<int> writers{0};
+    std::atomic<std::size_t> end{0};
+    std::atomic<std::uint64_t> recorded{0}, dropped{0};
+    char* data = nullptr;
+    std::size_t capacity = 0;
+    Clock::time_point startTime;
+    std::string path;
+#if defined(_WIN32)
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int file = -1;
+#endif
+};
+
+inline ofxOssiaRecorder::Writer::Writer(ofxOssiaRecorder& recorder, std::uint32_t handle, Kind kind, std::size_t size):
+  recorder(recorder)
+{
+  // registered before checking the flag, so that close() either sees this writer or stops it
+  recorder.writers.fetch_add(1);
+  if (!recorder.recording.load()) return;
+
+  std::size_t length = (sizeof(RecordHeader) + size + 7) & ~std::size_t(7);
+  std::size_t offset = recorder.end.fetch_add(length, std::memory_order_relaxed);
+  if (offset + length > recorder.capacity)
+  {
+    recorder.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  header = reinterpret_cast<RecordHeader*>(recorder.data + offset);
+  header->handle = handle;
+  header->time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - recorder.startTime).count();
+  header->size = std::uint32_t(size);
+  header->kind = kind;
+  payload = recorder.data + offset + sizeof(RecordHeader);
+}
+
+inline ofxOssiaRecorder::Writer::~Writer()
+{
+  if (header)
+  {
+    std::uint32_t length = std::uint32_t((sizeof(RecordHeader) + header->size + 7) & ~std::size_t(7));
+    std::atomic_thread_fence(std::memory_order_release);
+    header->length = length;
+    recorder.recorded.fetch_add(1, std::memory_order_relaxed);
+  }
+  recorder.writers.fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,111 @@
+#include "ofxOssiaReplayer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+bool ofxOssiaReplayer::load(const std::string& file)
+{
+  stop();
+  records.clear();
+  targets.clear();
+  next = 0;
+
+  std::ifstream in(ofToDataPath(file), std::ios::binary);
+  log.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+  ofxOssiaRecorder::FileHeader header{};
+  if (log.size() >= sizeof(header)) std::memcpy(&header, log.data(), sizeof(header));
+  if (std::memcmp(header.magic, ofxOssiaRecorder::magic, sizeof(header.magic)) != 0
+      || header.version < 1 || header.version > ofxOssiaRecorder::version){
+    ofLogWarning("ofxOssiaReplayer") << "could not read log " << file;
+    log.clear();
+    return false;
+  }
+
+  legacyNames = header.version == 1;
+
+  // stops at the first incomplete record
+  std::size_t offset = sizeof(header);
+  while (offset + sizeof(ofxOssiaRecorder::RecordHeader) <= log.size()){
+    ofxOssiaRecorder::RecordHeader record;
+    std::memcpy(&record, log.data() + offset, sizeof(record));
+    if (record.length < sizeof(record) + record.size || offset + record.length > log.size()) break;
+    records.push_back({record.time, record.handle, record.kind, offset + sizeof(record), record.size});
+    offset += record.length;
+  }
+
+  // records written concurrently (by the network and main threads) may be slightly out of order
+  std::stable_sort(records.begin(), records.end(),
+                   [](const Record& a, const Record& b){ return a.time < b.time; });
+  return true;
+}
+
+void ofxOssiaReplayer::start(float s)
+{
+  speed = s > 0 ? s : 1;
+  next = 0;
+  skipped = 0;
+  targets.clear();
+  startTime = Clock::now();
+  playing = !records.empty();
+}
+
+std::size_t ofxOssiaReplayer::update()
+{
+  if (!playing) return 0;
+  double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - startTime).count() * speed;
+  std::size_t until = next;
+  while (until < records.size() && records[until].time <= elapsed) ++until;
+  std::size_t applied = apply(until);
+  if (next == records.size()) playing = false;
+  return applied;
+}
+
+std::size_t ofxOssiaReplayer::replayAll()
+{
+  std::size_t applied = apply(records.size());
+  playing = false;
+  return applied;
+}
+
+std::size_t ofxOssiaReplayer::apply(std::size_t until)
+{
+  std::size_t applied = 0;
+  for (; next < until; ++next)
+    if (apply(records[next])) ++applied;
+  return applied;
+}
+
+bool ofxOssiaReplayer::apply(const Record& record)
+{
+  const char* payload = log.data() + record.offset;
+
+  if (record.kind == ofxOssiaRecorder::Declare){
+    // the name of the type, then the path
+    std::size_t typeLength = std::find(payload, payload + record.size, '\0') - payload;
+    std::string typeName(payload, typeLength);
+    std::string path = typeLength < record.size ? std::string(payload + typeLength + 1, record.size - typeLength - 1) : "";
+    ofxOssiaNode* node = server.find(path);
+    if (node && node->ops && typeName == (legacyNames ? node->ops->valueType->name() : *node->ops->typeName))
+      targets[record.handle] = {node->getHandle(), node->getGeneration(), node->ops->valueType};
+    else {
+      targets.erase(record.handle);
+      ofLogWarning("ofxOssiaReplayer") << "no parameter of type " << typeName << " at " << path;
+    }
+    return false;
+  }
+
+  bool received = record.kind == ofxOssiaRecorder::Received;
+  if (received ? !playReceived : !playSent) return false;
+
+  // the node might have been removed, or replaced, since
+  auto target = targets.find(record.handle);
+  ofxOssiaNode* node = target != targets.end() ? server.getNode(target->second.handle, target->second.generation) : nullptr;
+  if (!node || !node->ops || node->ops->valueType != target->second.valueType
+      || !(node->*node->ops->replay)(payload, record.size, received)){
+    ++skipped;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ofxOscQueryServer.h"
+#include <chrono>
+#include <unordered_map>
+
+/*
+ * Plays back a log written by ofxOscQueryServer::startRecording(), into a server:
+ * nodes are found by their path (and type), received values are set through
+ * their ossia node, as if received from the network again, and values that had been
+ * set by the application are set to their ofParameter.
+ * Records are applied from update(), in the order of their time,
+ * at their original speed or a multiple of it
+ * */
+
+class ofxOssiaReplayer {
+
+  public:
+
+    using Clock = std::chrono::steady_clock;
+
+    ofxOssiaReplayer(ofxOscQueryServer& server): server(server) {}
+
+    /**
+     * @brief reads a log (possibly incomplete, e.g. after a crash)
+     * @return false if it can't be read, or isn't a log
+     */
+    bool load(const std::string& file);
+
+    /**
+     * @brief starts playing from the beginning of the log
+     * @param speed 1 for the original timing, 2 for twice as fast...
+     */
+    void start(float speed = 1);
+    void stop(){ playing = false; }
+    bool isPlaying() const { return playing; }
+
+    // To be called from ofApp::update(): applies the records that are due, returns their number
+    std::size_t update();
+    // Applies all (remaining) records at once, regardless of their time
+    std::size_t replayAll();
+
+    // Which values are played back (both by default)
+    void setDirections(bool received, bool sent){ playReceived = received; playSent = sent; }
+
+    // Number of records, and duration of the log in seconds
+    std::size_t size() const { return records.size(); }
+    double getDuration() const { return records.empty() ? 0 : records.back().time / 1e9; }
+    // Number of records that couldn't be played back, their node not being found (or of another type)
+    std::size_t getSkipped() const { return skipped; }
+
+  private:
+
+    struct Record {
+      std::uint64_t time;
+      std::uint32_t handle;
+      std::uint8_t kind;
+      // of the payload in the log
+      std::size_t offset;
+      std::size_t size;
+    };
+
+    // The node of the server a recorded handle is played back to
+    struct Target {
+      std::uint32_t handle;
+      std::uint32_t generation;
+      const std::type_info* valueType;
+    };
+
+    std::size_t apply(std::size_t until);
+    bool apply(const Record& record);
+
+    ofxOscQueryServer& server;
+    std::vector<char> log;
+    std::vector<Record> records;
+    std::unordered_map<std::uint32_t, Target> targets;
+    // types named by typeid().name() (logs of version 1)
+    bool legacyNames = false;
+    std::size_t next = 0;
+    std::size_t skipped = 0;
+    bool playReceived = true, playSent = true;
+    bool playing = false;
+    float speed = 1;
+    Clock::time_point startTime;
+};
@@ -0,0 +1,7 @@
+#include "ofxOssiaSelection.h"
+#include "ofxOscQueryServer.h"
+
+ofxOssiaNode* ofxOssiaSelection::get(std::size_t i) const
+{
+  return server->getNode(handles[i], generations[i]);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ofxOscQueryServer;
+class ofxOssiaNode;
+
+/*
+ * The nodes of a server matching a path pattern (see ofxOscQueryServer::select()),
+ * in the order of the tree.
+ * A selection refers to the nodes by handle and generation, and is to be made again once nodes
+ * have been added or removed (those removed since are skipped, even when their handle has been reused)
+ * */
+
+class ofxOssiaSelection {
+
+  public:
+
+    std::size_t size() const { return handles.size(); }
+    bool empty() const { return handles.empty(); }
+    const std::vector<std::uint32_t>& getHandles() const { return handles; }
+
+    /**
+     * @brief sets the value of all the selected parameters of this type
+     * @param batched when true, the changes are published by the next flush (see ofxOscQueryServer::update())
+     * rather than one by one
+     * @return the number of parameters set, groups and parameters of other types being skipped
+     */
+    template<typename DataValue>
+    std::size_t set(const DataValue& value, bool batched = false);
+    std::size_t set(const char* value, bool batched = false){ return set(std::string(value), batched); }
+
+    class iterator {
+      public:
+        iterator(const ofxOssiaSelection& selection, std::size_t i): selection(selection), i(i) { skip(); }
+        ofxOssiaNode& operator*()  const { return *selection.get(i); }
+        ofxOssiaNode* operator->() const { return selection.get(i); }
+        iterator& operator++() { ++i; skip(); return *this; }
+        bool operator==(const iterator& other) const { return i == other.i; }
+        bool operator!=(const iterator& other) const { return i != other.i; }
+      private:
+        void skip() { while (i < selection.size() && !selection.get(i)) ++i; }
+        const ofxOssiaSelection& selection;
+        std::size_t i;
+    };
+
+    iterator begin() const { return iterator(*this, 0); }
+    iterator end()   const { return iterator(*this, size()); }
+
+  private:
+
+    friend class ofxOscQueryServer;
+
+    ofxOssiaSelection(ofxOscQueryServer& server, std::vector<std::uint32_t> handles, std::vector<std::uint32_t> generations):
+      server(&server), handles(std::move(handles)), generations(std::move(generations)) {}
+
+    // The i-th node, or nullptr if it has been removed
+    ofxOssiaNode* get(std::size_t i) const;
+
+    ofxOscQueryServer* server;
+    std::vector<std::uint32_t> handles;
+    std::vector<std::uint32_t> generations;
+};
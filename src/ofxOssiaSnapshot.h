@@ -0,0 +1,287 @@
+#pragma once
+
+#include "ofxOssiaTypes.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+/*
+ * Sequential ids of the types of ofParameter exposed by the servers,
+ * used to index per-type data
+ * */
+
+inline std::size_t ofxOssiaNextTypeId()
+{
+  static std::size_t next = 0;
+  return next++;
+}
+
+template<typename DataValue>
+std::size_t ofxOssiaTypeId()
+{
+  static const std::size_t id = ofxOssiaNextTypeId();
+  return id;
+}
+
+
+/*
+ * Values of a server's parameters, at a given time:
+ * stored by type, as columns of node handles (with their generation) and of values per type,
+ * see ofxOscQueryServer::snapshot() and recall()
+ * */
+
+class ofxOssiaSnapshot {
+
+  public:
+
+    class AbstractColumn {
+
+      public:
+
+        virtual ~AbstractColumn() = default;
+        virtual std::size_t typeId() const = 0;
+        virtual const std::type_info& valueType() const = 0;
+        // as written in snapshot files (see ossia::typeName())
+        virtual const std::string& typeName() const = 0;
+        virtual std::unique_ptr<AbstractColumn> clone() const = 0;
+
+        /**
+         * Values of trivially copyable types are saved as raw bytes (bool as one byte),
+         * std::string and arrays of trivially copyable types with their length:
+         * other types can't be saved.
+         * Reading expects the values to take exactly 'size' bytes of the stream
+         * @brief writes or reads the values of this column (in binary)
+         * @return false if this column's type can't be saved, the stream fails, or the values don't match their size
+         */
+        virtual bool writeValues(std::ostream& out) const = 0;
+        virtual bool readValues(std::istream& in, std::size_t count, std::size_t size) = 0;
+
+        // Removes the values of the nodes for which keep(handle, generation) is false
+        virtual void filter(const std::function<bool(std::uint32_t, std::uint32_t)>& keep) = 0;
+
+        // node handles and their generations, the values being in the same order
+        std::vector<std::uint32_t> handles;
+        std::vector<std::uint32_t> generations;
+    };
+
+    template<typename DataValue>
+    class Column : public AbstractColumn {
+
+      public:
+
+        void add(std::uint32_t handle, std::uint32_t generation, const DataValue& value)
+        {
+          handles.push_back(handle);
+          generations.push_back(generation);
+          values.push_back(value);
+        }
+
+        std::size_t typeId() const override { return ofxOssiaTypeId<DataValue>(); }
+        const std::type_info& valueType() const override { return typeid(DataValue); }
+        const std::string& typeName() const override { return ossia::typeName<DataValue>(); }
+        std::unique_ptr<AbstractColumn> clone() const override
+          { return std::unique_ptr<AbstractColumn>(new Column(*this)); }
+
+        bool writeValues(std::ostream& out) const override
+          { return write(out, Serialization<DataValue>()); }
+        bool readValues(std::istream& in, std::size_t count, std::size_t size) override
+        {
+          values.clear();
+          // each value takes at least one byte
+          if (count > size) return false;
+          values.resize(count);
+          return read(in, size, Serialization<DataValue>());
+        }
+
+        void filter(const std::function<bool(std::uint32_t, std::uint32_t)>& keep) override
+        {
+          std::size_t kept = 0;
+          for (std::size_t i = 0; i < handles.size(); ++i)
+          {
+            if (!keep(handles[i], generations[i])) continue;
+            handles[kept] = handles[i];
+            generations[kept] = generations[i];
+            values[kept] = values[i];
+            ++kept;
+          }
+          handles.resize(kept);
+          generations.resize(kept);
+          values.resize(kept);
+        }
+
+        std::vector<DataValue> values;
+
+      private:
+
+        enum class Raw {};
+        enum class Bool {};
+        enum class Text {};
+        enum class Array {};
+        enum class None {};
+        template<typename T> struct IsArray : std::false_type {};
+        template<typename T> struct IsArray<std::vector<T>>
+          : std::integral_constant<bool, std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value> {};
+        template<typename T>
+        using Serialization = typename std::conditional<std::is_same<T, bool>::value, Bool,
+                              typename std::conditional<std::is_trivially_copyable<T>::value, Raw,
+                              typename std::conditional<std::is_same<T, std::string>::value, Text,
+                              typename std::conditional<IsArray<T>::value, Array, None>::type>::type>::type>::type;
+
+        bool write(std::ostream& out, Raw) const
+        {
+          out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(DataValue));
+          return bool(out);
+        }
+        bool read(std::istream& in, std::size_t size, Raw)
+        {
+          if (size != values.size() * sizeof(DataValue)) return false;
+          if (values.empty()) return true;
+          in.read(reinterpret_cast<char*>(&values[0]), values.size() * sizeof(DataValue));
+          return bool(in);
+        }
+
+        // std::vector<bool> being packed, one byte per value
+        bool write(std::ostream& out, Bool) const
+        {
+          for (bool v : values) out.put(v ? 1 : 0);
+          return bool(out);
+        }
+        bool read(std::istream& in, std::size_t size, Bool)
+        {
+          if (size != values.size()) return false;
+          for (std::size_t i = 0; i < values.size(); ++i)
+          {
+            char c;
+            if (!in.get(c)) return false;
+            values[i] = c != 0;
+          }
+          return true;
+        }
+
+        bool write(std::ostream& out, Text) const
+        {
+          for (const auto& v : values) writeString(out, v);
+          return bool(out);
+        }
+        bool read(std::istream& in, std::size_t size, Text)
+        {
+          for (auto& v : values)
+          {
+            if (size < sizeof(std::uint32_t) || !readString(in, v, size - sizeof(std::uint32_t))) return false;
+            size -= sizeof(std::uint32_t) + v.size();
+          }
+          return size == 0;
+        }
+
+        // arrays with their number of elements, then their elements as raw bytes
+        bool write(std::ostream& out, Array) const
+        {
+          for (const auto& v : values)
+          {
+            std::uint32_t size = std::uint32_t(v.size());
+            out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            if (size) out.write(reinterpret_cast<const char*>(v.data()), size * sizeof(v[0]));
+          }
+          return bool(out);
+        }
+        bool read(std::istream& in, std::size_t size, Array)
+        {
+          for (auto& v : values)
+          {
+            std::uint32_t length = 0;
+            if (size < sizeof(length) || !in.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+            size -= sizeof(length);
+            if (length > size / sizeof(v[0])) return false;
+            v.resize(length);
+            if (length && !in.read(reinterpret_cast<char*>(&v[0]), length * sizeof(v[0]))) return false;
+            size -= length * sizeof(v[0]);
+          }
+          return size == 0;
+        }
+
+        bool write(std::ostream&, None) const { return false; }
+        bool read(std::istream&, std::size_t, None) { return false; }
+    };
+
+    ofxOssiaSnapshot() = default;
+    ofxOssiaSnapshot(ofxOssiaSnapshot&&) = default;
+    ofxOssiaSnapshot& operator=(ofxOssiaSnapshot&&) = default;
+    ofxOssiaSnapshot(const ofxOssiaSnapshot& other) { *this = other; }
+    ofxOssiaSnapshot& operator=(const ofxOssiaSnapshot& other)
+    {
+      if (this == &other) return *this;
+      columns.clear();
+      for (const auto& c : other.columns) columns.push_back(c ? c->clone() : nullptr);
+      return *this;
+    }
+
+    // The column of a type, created if needed
+    template<typename DataValue>
+    Column<DataValue>& column()
+    {
+      std::size_t id = ofxOssiaTypeId<DataValue>();
+      if (id >= columns.size()) columns.resize(id + 1);
+      if (!columns[id]) columns[id].reset(new Column<DataValue>);
+      return static_cast<Column<DataValue>&>(*columns[id]);
+    }
+
+    // The column of a type, or nullptr
+    template<typename DataValue>
+    const Column<DataValue>* find() const
+    {
+      std::size_t id = ofxOssiaTypeId<DataValue>();
+      return id < columns.size() ? static_cast<const Column<DataValue>*>(columns[id].get()) : nullptr;
+    }
+
+    // Adds a column read from a file
+    void add(std::unique_ptr<AbstractColumn> c)
+    {
+      std::size_t id = c->typeId();
+      if (id >= columns.size()) columns.resize(id + 1);
+      columns[id] = std::move(c);
+    }
+
+    // Only keeps the values of the nodes for which keep(handle, generation) is true
+    void filter(const std::function<bool(std::uint32_t, std::uint32_t)>& keep)
+      { for (auto& c : columns) if (c) c->filter(keep); }
+
+    // Number of values
+    std::size_t size() const
+    {
+      std::size_t n = 0;
+      for (const auto& c : columns) if (c) n += c->handles.size();
+      return n;
+    }
+    bool empty() const { return size() == 0; }
+    void clear() { columns.clear(); }
+
+    // Columns, indexed by type id (some may be null)
+    const std::vector<std::unique_ptr<AbstractColumn>>& getColumns() const { return columns; }
+
+    static void writeString(std::ostream& out, const std::string& s)
+    {
+      std::uint32_t length = std::uint32_t(s.size());
+      out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      out.write(s.data(), length);
+    }
+
+    // fails if the string is longer than maxLength
+    static bool readString(std::istream& in, std::string& s, std::uint64_t maxLength = UINT32_MAX)
+    {
+      std::uint32_t length = 0;
+      if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > maxLength) return false;
+      s.resize(length);
+      return length == 0 || bool(in.read(&s[0], length));
+    }
+
+  private:
+
+    std::vector<std::unique_ptr<AbstractColumn>> columns;
+};
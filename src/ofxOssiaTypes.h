@@ -3,7 +3,12 @@
 #include <types/ofBaseTypes.h>
 #include <math/ofVectorMath.h>
 #include <string>
+#include <typeinfo>
 #include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #undef Status
 #undef Bool
@@ -19,25 +24,30 @@ namespace ossia
  * the compatible OSSIA & OpenFrameworks types.
  * Copied from https://github.com/OSSIA/ofxOssia/blob/master/src/OssiaTypes.h
  *
+ * They are called for every value sent or received: opp::values are taken by
+ * reference (copying one allocates its ossia::value), and fetched only once
  */
 template<typename> struct MatchingType;
 
+template<typename...> struct TypeList {};
+
 template<> struct MatchingType<float> {
     using ofx_type = float;
     using ossia_type = float;
+    static std::string name(){ return "float"; }
 
     static opp::node create_parameter(const std::string& name,
                                       opp::node parent)
     {return parent.create_float(name);}
 
-    static bool is_valid(opp::value v){ return v.is_float(); }
+    static bool is_valid(const opp::value& v){ return v.is_float(); }
 
     static ofx_type convertFromOssia(const opp::value& v)
     {
       return v.to_float();
     }
 
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
       return float(f);
     }
@@ -47,19 +57,20 @@ template<> struct MatchingType<float> {
 template<> struct MatchingType<int> {
     using ofx_type = int;
     using ossia_type = int;
+    static std::string name(){ return "int"; }
 
     static opp::node create_parameter(const std::string& name,
                                       opp::node parent)
     {return parent.create_int(name);}
 
-    static bool is_valid(opp::value v){ return v.is_int(); }
+    static bool is_valid(const opp::value& v){ return v.is_int(); }
 
     static ofx_type convertFromOssia(const opp::value& v)
     {
       return v.to_int();
     }
 
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
       return int(f);
     }
@@ -69,19 +80,20 @@ template<> struct MatchingType<int> {
 template<> struct MatchingType<bool> {
     using ofx_type = bool;
     using ossia_type = bool;
+    static std::string name(){ return "bool"; }
 
     static opp::node create_parameter(const std::string& name,
                                       opp::node parent)
     {return parent.create_bool(name);}
 
-    static bool is_valid(opp::value v){ return v.is_bool(); }
+    static bool is_valid(const opp::value& v){ return v.is_bool(); }
 
     static ofx_type convertFromOssia(const opp::value& v)
     {
       return v.to_bool();
     }
 
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
       return bool(f);
     }
@@ -90,18 +102,19 @@ template<> struct MatchingType<bool> {
 template<> struct MatchingType<double> {
     using ofx_type = double;
     using ossia_type = float;
+    static std::string name(){ return "double"; }
 
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_float(name);}
 
-    static bool is_valid(opp::value v){ return v.is_float(); }
+    static bool is_valid(const opp::value& v){ return v.is_float(); }
 
     static ofx_type convertFromOssia(const opp::value& v)
     {
       return ofx_type(v.to_float());
     }
 
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
       return float(f);
     }
@@ -110,18 +123,20 @@ template<> struct MatchingType<double> {
 template<> struct MatchingType<glm::vec2> {
     using ofx_type = glm::vec2;
     using ossia_type = opp::value::vec2f;
+    static std::string name(){ return "glm::vec2"; }
     
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_vec2f(name);}
     
-    static bool is_valid(opp::value v){ return v.is_vec2f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec2f(); }
     
     static ofx_type convertFromOssia(const opp::value& v)
     {
-        return ofx_type(v.to_vec2f()[0], v.to_vec2f()[1]);
+        const ossia_type c = v.to_vec2f();
+        return ofx_type(c[0], c[1]);
     }
     
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
         return ossia_type{f.x, f.y};
     }
@@ -130,18 +145,20 @@ template<> struct MatchingType<glm::vec2> {
 template<> struct MatchingType<glm::vec3> {
     using ofx_type = glm::vec3;
     using ossia_type = opp::value::vec3f;
+    static std::string name(){ return "glm::vec3"; }
     
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_vec3f(name);}
     
-    static bool is_valid(opp::value v){ return v.is_vec3f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec3f(); }
     
     static ofx_type convertFromOssia(const opp::value& v)
     {
-        return ofx_type(v.to_vec3f()[0], v.to_vec3f()[1], v.to_vec3f()[2]);
+        const ossia_type c = v.to_vec3f();
+        return ofx_type(c[0], c[1], c[2]);
     }
     
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
         return ossia_type{f.x, f.y, f.z};
     }
@@ -150,18 +167,20 @@ template<> struct MatchingType<glm::vec3> {
 template<> struct MatchingType<glm::vec4> {
     using ofx_type = glm::vec4;
     using ossia_type = opp::value::vec4f;
+    static std::string name(){ return "glm::vec4"; }
     
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_vec4f(name);}
     
-    static bool is_valid(opp::value v){ return v.is_vec4f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec4f(); }
     
     static ofx_type convertFromOssia(const opp::value& v)
     {
-        return ofx_type(v.to_vec4f()[0], v.to_vec4f()[1], v.to_vec4f()[2], v.to_vec4f()[3]);
+        const ossia_type c = v.to_vec4f();
+      return ofx_type(c[0], c[1], c[2], c[3]);
     }
     
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
         return ossia_type{f.x, f.y, f.z, f.w};
     }
@@ -170,18 +189,20 @@ template<> struct MatchingType<glm::vec4> {
 template<> struct MatchingType<ofVec2f> {
     using ofx_type = ofVec2f;
     using ossia_type = opp::value::vec2f;
+    static std::string name(){ return "ofVec2f"; }
     
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_vec2f(name);}
     
-    static bool is_valid(opp::value v){ return v.is_vec2f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec2f(); }
     
     static ofx_type convertFromOssia(const opp::value& v)
     {
-        return ofx_type(v.to_vec2f()[0], v.to_vec2f()[1]);
+        const ossia_type c = v.to_vec2f();
+        return ofx_type(c[0], c[1]);
     }
     
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
         return ossia_type{f.x, f.y};
     }
@@ -190,18 +211,20 @@ template<> struct MatchingType<ofVec2f> {
 template<> struct MatchingType<ofVec3f> {
     using ofx_type = ofVec3f;
     using ossia_type = opp::value::vec3f;
+    static std::string name(){ return "ofVec3f"; }
     
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_vec3f(name);}
     
-    static bool is_valid(opp::value v){ return v.is_vec3f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec3f(); }
     
     static ofx_type convertFromOssia(const opp::value& v)
     {
-        return ofx_type(v.to_vec3f()[0], v.to_vec3f()[1], v.to_vec3f()[2]);
+        const ossia_type c = v.to_vec3f();
+        return ofx_type(c[0], c[1], c[2]);
     }
     
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
         return ossia_type{f.x, f.y, f.z};
     }
@@ -210,18 +233,20 @@ template<> struct MatchingType<ofVec3f> {
 template<> struct MatchingType<ofVec4f> {
     using ofx_type = ofVec4f;
     using ossia_type = opp::value::vec4f;
+    static std::string name(){ return "ofVec4f"; }
     
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_vec4f(name);}
     
-    static bool is_valid(opp::value v){ return v.is_vec4f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec4f(); }
     
     static ofx_type convertFromOssia(const opp::value& v)
     {
-        return ofx_type(v.to_vec4f()[0], v.to_vec4f()[1], v.to_vec4f()[2], v.to_vec4f()[3]);
+        const ossia_type c = v.to_vec4f();
+      return ofx_type(c[0], c[1], c[2], c[3]);
     }
     
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
         return ossia_type{f.x, f.y, f.z, f.w};
     }
@@ -230,18 +255,20 @@ template<> struct MatchingType<ofVec4f> {
 template<> struct MatchingType<ofColor> {
     using ofx_type = ofColor;
     using ossia_type = opp::value::vec4f;
+    static std::string name(){ return "ofColor"; }
 
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_rgba8(name);}
 
-    static bool is_valid(opp::value v){ return v.is_vec4f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec4f(); }
 
     static ofx_type convertFromOssia(const opp::value& v)
     {
-      return ofx_type(v.to_vec4f()[0], v.to_vec4f()[1], v.to_vec4f()[2], v.to_vec4f()[3]);
+      const ossia_type c = v.to_vec4f();
+      return ofx_type(c[0], c[1], c[2], c[3]);
     }
 
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
       return ossia_type{float(f.r), float(f.g), float(f.b), float(f.a)};
     }
@@ -250,18 +277,20 @@ template<> struct MatchingType<ofColor> {
 template<> struct MatchingType<ofFloatColor> {
     using ofx_type = ofFloatColor;
     using ossia_type = opp::value::vec4f;
+    static std::string name(){ return "ofFloatColor"; }
     
     static opp::node create_parameter(const std::string& name, opp::node parent)
     {return parent.create_rgba(name);}
 
-    static bool is_valid(opp::value v){ return v.is_vec4f(); }
+    static bool is_valid(const opp::value& v){ return v.is_vec4f(); }
     
     static ofx_type convertFromOssia(const opp::value& v)
     {
-        return ofx_type(v.to_vec4f()[0], v.to_vec4f()[1], v.to_vec4f()[2], v.to_vec4f()[3]);
+        const ossia_type c = v.to_vec4f();
+      return ofx_type(c[0], c[1], c[2], c[3]);
     }
     
-    static ossia_type convert(ofx_type f)
+    static ossia_type convert(const ofx_type& f)
     {
         return ossia_type{f.r, f.g, f.b, f.a};
     }
@@ -271,22 +300,155 @@ template<> struct MatchingType<ofFloatColor> {
 template<> struct MatchingType<std::string> {
     using ofx_type = std::string;
     using ossia_type = std::string;
+    static std::string name(){ return "std::string"; }
 
     static opp::node create_parameter(const std::string& name,
                                       opp::node parent)
     {return parent.create_string(name);}
 
-    static bool is_valid(opp::value v){ return v.is_string(); }
+    static bool is_valid(const opp::value& v){ return v.is_string(); }
 
     static ofx_type convertFromOssia(const opp::value& v)
     {
       return v.to_string();
     }
 
-    static ossia_type convert(ofx_type f)
+    // the string is only copied once, by the opp::value it is converted to
+    static const ossia_type& convert(const ofx_type& f)
+    {
+      return f;
+    }
+};
+
+/**
+ * Arrays (ofParameter<std::vector<Element>>) are exposed as a single list node,
+ * sent and received as one message: each element is flattened to its components
+ * (4 for colors), and numbers are accepted as either floats or ints.
+ * The list received is fetched once, and converted in one pass
+ */
+inline float listComponent(const opp::value& v)
+{ return v.is_float() ? v.to_float() : v.is_int() ? float(v.to_int()) : 0.f; }
+
+template<typename> struct ListElement;
+
+template<> struct ListElement<float> {
+    static constexpr std::size_t count = 1;
+    static void append(float e, std::vector<opp::value>& list){ list.emplace_back(e); }
+    static float read(const opp::value* c){ return listComponent(c[0]); }
+};
+
+template<> struct ListElement<int> {
+    static constexpr std::size_t count = 1;
+    static void append(int e, std::vector<opp::value>& list){ list.emplace_back(e); }
+    static int read(const opp::value* c){ return c[0].is_int() ? c[0].to_int() : int(std::lround(listComponent(c[0]))); }
+};
+
+template<> struct ListElement<ofFloatColor> {
+    static constexpr std::size_t count = 4;
+    static void append(const ofFloatColor& e, std::vector<opp::value>& list)
+    { for (int i = 0; i < 4; ++i) list.emplace_back(e[i]); }
+    static ofFloatColor read(const opp::value* c)
+    { return ofFloatColor(listComponent(c[0]), listComponent(c[1]), listComponent(c[2]), listComponent(c[3])); }
+};
+
+template<> struct ListElement<ofColor> {
+    static constexpr std::size_t count = 4;
+    static void append(const ofColor& e, std::vector<opp::value>& list)
+    { for (int i = 0; i < 4; ++i) list.emplace_back(int(e[i])); }
+    static ofColor read(const opp::value* c)
+    {
+      ofColor e;
+      for (int i = 0; i < 4; ++i) e[i] = (unsigned char)(std::min(255.f, std::max(0.f, listComponent(c[i]) + 0.5f)));
+      return e;
+    }
+};
+
+template<typename Element> struct MatchingType<std::vector<Element>> {
+    using ofx_type = std::vector<Element>;
+    using ossia_type = std::vector<opp::value>;
+    using element = ListElement<Element>;
+    static std::string name(){ return "std::vector<" + MatchingType<Element>::name() + ">"; }
+
+    static opp::node create_parameter(const std::string& name, opp::node parent)
+    {return parent.create_list(name);}
+
+    static bool is_valid(const opp::value& v){ return v.is_list(); }
+
+    // trailing components that don't make a whole element are ignored
+    static ofx_type convertFromOssia(const opp::value& v)
+    {
+      const ossia_type list = v.to_list();
+      ofx_type res(list.size() / element::count);
+      for (std::size_t i = 0; i < res.size(); ++i) res[i] = element::read(&list[i * element::count]);
+      return res;
+    }
+
+    static ossia_type convert(const ofx_type& f)
     {
-      return std::string(f);
+      ossia_type res;
+      res.reserve(f.size() * element::count);
+      for (const auto& e : f) element::append(e, res);
+      return res;
     }
 };
 
+/**
+ * Distance between two values of a same type, as used by deadbands:
+ * the largest difference between their components.
+ * Values of other types (bool, std::string, custom types...) are either
+ * equal (0) or infinitely distant
+ */
+template<typename T>
+double distance(const T& a, const T& b)
+{ return a == b ? 0 : std::numeric_limits<double>::infinity(); }
+
+template<std::size_t N, typename T>
+double componentDistance(const T& a, const T& b)
+{
+  double d = 0;
+  for (std::size_t i = 0; i < N; ++i) d = std::max(d, std::abs(double(a[i]) - double(b[i])));
+  return d;
+}
+
+inline double distance(const float& a, const float& b)  { return std::abs(double(a) - double(b)); }
+inline double distance(const int& a, const int& b)      { return std::abs(double(a) - double(b)); }
+inline double distance(const double& a, const double& b){ return std::abs(a - b); }
+inline double distance(const glm::vec2& a, const glm::vec2& b)      { return componentDistance<2>(a, b); }
+inline double distance(const glm::vec3& a, const glm::vec3& b)      { return componentDistance<3>(a, b); }
+inline double distance(const glm::vec4& a, const glm::vec4& b)      { return componentDistance<4>(a, b); }
+inline double distance(const ofVec2f& a, const ofVec2f& b)          { return componentDistance<2>(a, b); }
+inline double distance(const ofVec3f& a, const ofVec3f& b)          { return componentDistance<3>(a, b); }
+inline double distance(const ofVec4f& a, const ofVec4f& b)          { return componentDistance<4>(a, b); }
+inline double distance(const ofColor& a, const ofColor& b)          { return componentDistance<4>(a, b); }
+inline double distance(const ofFloatColor& a, const ofFloatColor& b){ return componentDistance<4>(a, b); }
+
+/**
+ * Name of a type, as written in snapshot files and recordings:
+ * stable across compilers, as given by MatchingType<T>::name(),
+ * or the compiler's own name for types whose MatchingType has none
+ */
+template<typename T>
+auto typeNameOf(int) -> decltype(MatchingType<T>::name()) { return MatchingType<T>::name(); }
+template<typename T>
+std::string typeNameOf(long) { return typeid(T).name(); }
+
+template<typename T>
+const std::string& typeName()
+{
+  static const std::string name = typeNameOf<T>(0);
+  return name;
+}
+
+/**
+ * All types supported out of the box by ofxOscQueryServer
+ * Other types can be supported by specializing MatchingType for them (with a name()),
+ * and registering them with ofxOscQueryServer::registerType
+ */
+using MatchingTypes = TypeList<float, int, bool, double,
+                               glm::vec2, glm::vec3, glm::vec4,
+                               ofVec2f, ofVec3f, ofVec4f,
+                               ofColor, ofFloatColor, std::string,
+                               std::vector<float>, std::vector<int>,
+                               std::vector<ofFloatColor>, std::vector<ofColor>>;
+
 } // namespace ossia
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <types/ofParameter.h>
+#include "ofxOssiaTypes.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Marks, for the current thread, the node being updated:
+ * - ofxOssiaRemoteUpdate: its ofParameter is being set from a value received
+ *   from the network, so its listener knows that this value doesn't come from the application
+ * - ofxOssiaLocalUpdate: its ossia node is being set from the ofParameter,
+ *   so its value callback knows that this value is only an echo of its own
+ * */
+
+template<int Direction>
+class ofxOssiaUpdateMarker {
+
+  public:
+
+    ofxOssiaUpdateMarker(const void* node): previous(current()) { current() = node; }
+    ~ofxOssiaUpdateMarker() { current() = previous; }
+
+    static const void*& current()
+    {
+      static thread_local const void* node = nullptr;
+      return node;
+    }
+
+  private:
+
+    const void* previous;
+};
+
+using ofxOssiaRemoteUpdate = ofxOssiaUpdateMarker<0>;
+using ofxOssiaLocalUpdate  = ofxOssiaUpdateMarker<1>;
+
+
+/*
+ * Pending value received from the network for one node,
+ * waiting to be applied to its ofParameter from the main thread
+ * The network and main threads exchange it under a spin lock, only held to copy or compare a value:
+ * a thread finding it busy spins briefly, then yields, e.g. to let a preempted holder finish
+ * */
+
+class ofxOssiaAbstractSlot {
+
+  public:
+
+    virtual ~ofxOssiaAbstractSlot() = default;
+
+    // Applies the pending value (if any) to the ofParameter, with or without notifying its listeners
+    // returns whether the ofParameter has changed
+    virtual bool apply(bool notify) = 0;
+    // Drops the pending value (if any)
+    virtual void discard() = 0;
+
+    // Whether this slot's node is already waiting in the queue
+    std::atomic<bool> queued{false};
+    // Whether its node is staged in a transaction: its value is then left to the transaction,
+    // even if the node was already waiting in the queue (see ofxOssiaUpdateQueue::applyPending())
+    std::atomic<bool> staged{false};
+
+  protected:
+
+    void lock()
+    {
+      for (int spins = 0; busy.test_and_set(std::memory_order_acquire); ++spins)
+        if (spins >= 64) std::this_thread::yield();
+    }
+    void unlock() { busy.clear(std::memory_order_release); }
+
+  private:
+
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+};
+
+template<typename DataValue>
+class ofxOssiaValueSlot : public ofxOssiaAbstractSlot {
+
+  public:
+
+    // 'node' marks the values applied as received (see ofxOssiaRemoteUpdate)
+    ofxOssiaValueSlot(ofParameter<DataValue>& param, const void* node): param(param), node(node), published(param.get()) {}
+
+    // Called from the network thread: only the latest value is kept
+    void store(DataValue&& value)
+    {
+      lock();
+      published = value;
+      pending = std::move(value);
+      fresh = true;
+      unlock();
+    }
+
+    // Last value held by the ossia node, either published or received
+    void setPublished(const DataValue& value)
+    {
+      lock();
+      published = value;
+      unlock();
+    }
+
+    bool isPublished(const DataValue& value)
+    {
+      lock();
+      bool same = (published == value);
+      unlock();
+      return same;
+    }
+
+    // How far a value is from the one held by the ossia node
+    double distanceToPublished(const DataValue& value)
+    {
+      lock();
+      double d = ossia::distance(published, value);
+      unlock();
+      return d;
+    }
+
+    bool apply(bool notify) override
+    {
+      // Clear the flag first, so that a value stored while we apply
+      // this one gets its node queued again
+      queued.store(false);
+
+      lock();
+      if (!fresh) { unlock(); return false; }
+      DataValue value = std::move(pending);
+      fresh = false;
+      unlock();
+
+      if (value == param.get()) return false;
+      // the node's listener must not take it for a change made by the application
+      ofxOssiaRemoteUpdate remote(node);
+      if (notify) param.set(value);
+      else param.setWithoutEventNotifications(value);
+      return true;
+    }
+
+    void discard() override
+    {
+      queued.store(false);
+      lock();
+      fresh = false;
+      unlock();
+    }
+
+  private:
+
+    ofParameter<DataValue>& param;
+    const void* node;
+    DataValue published;
+    DataValue pending{};
+    bool fresh = false;
+};
+
+
+/*
+ * Nodes of a transactional group (see ofxOscQueryServer::setTransactional())
+ * whose received value is stored in their slot, waiting for the transaction to be committed.
+ * Filled by libossia's network thread(s), taken from the main thread
+ * */
+
+class ofxOssiaStagedUpdates {
+
+  public:
+
+    // Once the value has been stored in the node's slot
+    void stage(std::uint32_t id, ofxOssiaAbstractSlot& slot)
+    {
+      if (slot.staged.exchange(true)) return; // already staged
+      std::lock_guard<std::mutex> lock(mutex);
+      ids.push_back(id);
+    }
+
+    // The nodes staged since the last call
+    void take(std::vector<std::uint32_t>& taken)
+    {
+      taken.clear();
+      std::lock_guard<std::mutex> lock(mutex);
+      std::swap(ids, taken);
+    }
+
+  private:
+
+    std::mutex mutex;
+    std::vector<std::uint32_t> ids;
+};
+
+
+/*
+ * Bounded queue of node ids (without mutex), filled by libossia's network thread(s)
+ * and drained from the main thread (multiple producers, single consumer)
+ * Each node is queued at most once at a time, so bursts of messages sent
+ * to the same node are coalesced: only the last value received is applied
+ * */
+
+class ofxOssiaUpdateQueue {
+
+  public:
+
+    ofxOssiaUpdateQueue() = default;
+    ofxOssiaUpdateQueue(const ofxOssiaUpdateQueue&) = delete;
+    ofxOssiaUpdateQueue& operator=(const ofxOssiaUpdateQueue&) = delete;
+
+    /**
+     * @brief registers a node's slot, under the id used to queue this node
+     */
+    void add(std::uint32_t id, ofxOssiaAbstractSlot* slot)
+    {
+      if (id >= slots.size()) slots.resize(id + 1, nullptr);
+      slots[id] = slot;
+    }
+
+    /**
+     * @brief unregisters a node's slot, any pending value for it is dropped
+     */
+    void remove(std::uint32_t id)
+    {
+      if (id < slots.size()) slots[id] = nullptr;
+    }
+
+    /**
+     * Enabling deferred mode allocates the queue: its capacity is rounded
+     * up to a power of two, and only taken into account the first time.
+     * Should it overflow, pending nodes are still found by scanning all slots.
+     * @brief sets whether received values are queued (true) or applied right away (false)
+     */
+    void setDeferred(bool d, std::size_t capacity)
+    {
+      if (d && !cells)
+      {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; ++i)
+          cells[i].sequence.store(i, std::memory_order_relaxed);
+        mask = size - 1;
+      }
+      deferred.store(d, std::memory_order_release);
+    }
+
+    bool isDeferred() const
+      { return deferred.load(std::memory_order_acquire); }
+
+    /**
+     * @brief queues a node whose slot has just been stored into (network thread)
+     */
+    void enqueue(std::uint32_t id, ofxOssiaAbstractSlot& slot)
+    {
+      if (slot.queued.exchange(true)) return; // already waiting
+      if (!push(id)) overflowed.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief applies all pending values to their ofParameters (main thread)
+     * @return the number of nodes that have been applied
+     */
+    std::size_t applyPending()
+    {
+      if (!cells) return 0;
+
+      std::size_t applied = 0;
+      std::uint32_t id;
+      // Bounded, so that a continuous flood of messages can't stall the main thread
+      std::size_t budget = slots.size();
+      while (budget-- > 0 && pop(id))
+      {
+        if (id < slots.size() && slots[id] && apply(*slots[id])) ++applied;
+      }
+
+      if (overflowed.exchange(false))
+      {
+        for (auto slot : slots)
+          if (slot && slot->queued.load() && apply(*slot)) ++applied;
+      }
+      return applied;
+    }
+
+  private:
+
+    // Staged since it was queued: its value is applied when the transaction is committed
+    static bool apply(ofxOssiaAbstractSlot& slot)
+    {
+      if (!slot.staged.load()) { slot.apply(true); return true; }
+      slot.queued.store(false);
+      return false;
+    }
+
+    // Dmitry Vyukov's bounded queue, with a single consumer
+    struct Cell {
+      std::atomic<std::size_t> sequence;
+      std::uint32_t id;
+    };
+
+    bool push(std::uint32_t id)
+    {
+      Cell* cell;
+      std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        cell = &cells[pos & mask];
+        std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = std::intptr_t(seq) - std::intptr_t(pos);
+        if (diff == 0)
+        {
+          if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (diff < 0) return false; // full
+        else pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+      cell->id = id;
+      cell->sequence.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool pop(std::uint32_t& id)
+    {
+      Cell* cell = &cells[dequeuePos & mask];
+      std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+      if (std::intptr_t(seq) - std::intptr_t(dequeuePos + 1) < 0) return false; // empty
+      id = cell->id;
+      cell->sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+      ++dequeuePos;
+      return true;
+    }
+
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask = 0;
+    // The producers' and the consumer's positions are kept on separate cache lines
+    // (padded rather than alignas(64), so that the server can still be allocated with new in C++14)
+    char padding0[64];
+    std::atomic<std::size_t> enqueuePos{0};
+    char padding1[64];
+    std::size_t dequeuePos = 0;
+
+    std::atomic<bool> deferred{false};
+    std::atomic<bool> overflowed{false};
+
+    // Indexed by node id, only accessed from the main thread
+    std::vector<ofxOssiaAbstractSlot*> slots;
+};